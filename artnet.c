@@ -0,0 +1,39 @@
+/** \file
+ * Art-Net receiver: ArtDmx and ArtSync parsing.
+ */
+#include <string.h>
+#include "artnet.h"
+
+#define ARTNET_ID "Art-Net"
+#define ARTNET_MIN_PROTOCOL_VERSION 14
+
+
+bool
+artnet_parse(
+	const uint8_t * buf,
+	size_t len,
+	artnet_packet_t * const packet
+)
+{
+	// id (8 bytes, with its null), opcode (little endian), protocol version (big endian)
+	if (len < 12 || memcmp(buf, ARTNET_ID, sizeof(ARTNET_ID)) != 0)
+		return false;
+	packet->opcode = buf[8] | (buf[9] << 8);
+	if (((buf[10] << 8) | buf[11]) < ARTNET_MIN_PROTOCOL_VERSION)
+		return false;
+
+	if (packet->opcode == ARTNET_OP_SYNC)
+		return true;
+	if (packet->opcode != ARTNET_OP_DMX || len < ARTNET_DMX_HEADER_SIZE)
+		return false;
+
+	packet->sequence = buf[12];
+	packet->universe = (buf[14] | (buf[15] << 8)) & 0x7FFF;
+	packet->length = (buf[16] << 8) | buf[17];
+	packet->data = buf + ARTNET_DMX_HEADER_SIZE;
+	if (packet->length > 512 || packet->length > len - ARTNET_DMX_HEADER_SIZE)
+		return false;
+
+	return true;
+}
+
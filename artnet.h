@@ -0,0 +1,39 @@
+/** \file
+ * Art-Net receiver: ArtDmx and ArtSync parsing.
+ *
+ * Universes are mapped onto strips by a universe_map_t, see universe.h.
+ */
+#ifndef _artnet_h_
+#define _artnet_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ARTNET_PORT 6454
+#define ARTNET_OP_DMX 0x5000
+#define ARTNET_OP_SYNC 0x5200
+#define ARTNET_DMX_HEADER_SIZE 18
+#define ARTNET_MAX_UNIVERSE 0x7FFF
+
+typedef struct {
+	uint16_t opcode;
+	uint16_t universe; // 15 bit port address: net, sub net and universe
+	uint8_t sequence;
+	const uint8_t * data;
+	uint16_t length;
+} artnet_packet_t;
+
+
+/** Parse an ArtDmx or ArtSync packet.
+ *
+ * \returns false for anything else, or malformed packets.
+ */
+extern bool
+artnet_parse(
+	const uint8_t * buf,
+	size_t len,
+	artnet_packet_t * const packet
+);
+
+#endif
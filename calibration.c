@@ -0,0 +1,227 @@
+/** \file
+ * Per pixel brightness and tint calibration.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include "calibration.h"
+#include "util.h"
+
+#ifdef __ARM_NEON__
+#include <arm_neon.h>
+#endif
+
+#define CALIBRATION_MAX_GAIN (255.0 / CALIBRATION_GAIN_ONE)
+
+enum {
+	CHANNEL_R,
+	CHANNEL_G,
+	CHANNEL_B,
+	CHANNEL_W,
+	NUM_CHANNELS
+};
+
+
+calibration_t *
+calibration_init(
+	unsigned num_strips,
+	unsigned num_pixels
+)
+{
+	calibration_t * const calibration = calloc(1, sizeof(*calibration));
+	if (!calibration)
+		die("calibration: unable to allocate\n");
+
+	calibration->num_strips = num_strips;
+	calibration->num_pixels = num_pixels;
+	calibration->frame_size = ledscape_frame_size(num_strips, num_pixels);
+	calibration->gains = malloc(calibration->frame_size);
+	if (!calibration->gains)
+		die("calibration: unable to allocate %zu bytes\n", calibration->frame_size);
+
+	memset(calibration->gains, CALIBRATION_GAIN_ONE, calibration->frame_size);
+
+	return calibration;
+}
+
+
+/** Write the channel gains of one pixel in the byte order of the frame.
+ *
+ * This must match ledscape_set_color() and ledscape_set_color_rgbw().
+ */
+static void
+calibration_set_pixel(
+	calibration_t * const calibration,
+	unsigned strip,
+	unsigned pixel,
+	const uint8_t gains[NUM_CHANNELS],
+	bool rgbw
+)
+{
+	uint8_t * const out = (uint8_t *) ledscape_pixel(
+		(ledscape_frame_t *) calibration->gains,
+		calibration->num_strips,
+		strip,
+		pixel
+	);
+
+	if (rgbw)
+	{
+		out[offsetof(ledscape_pixel_t, unused)] = gains[CHANNEL_R];
+		out[offsetof(ledscape_pixel_t, c)] = gains[CHANNEL_G];
+		out[offsetof(ledscape_pixel_t, b)] = gains[CHANNEL_B];
+		out[offsetof(ledscape_pixel_t, a)] = gains[CHANNEL_W];
+	}
+	else
+	{
+		out[offsetof(ledscape_pixel_t, c)] = gains[CHANNEL_R];
+		out[offsetof(ledscape_pixel_t, b)] = gains[CHANNEL_G];
+		out[offsetof(ledscape_pixel_t, a)] = gains[CHANNEL_B];
+		out[offsetof(ledscape_pixel_t, unused)] = CALIBRATION_GAIN_ONE;
+	}
+}
+
+
+/** Parse the gains at the end of an entry. w is optional */
+static bool
+calibration_parse_gains(
+	const double values[NUM_CHANNELS],
+	int count,
+	uint8_t gains[NUM_CHANNELS]
+)
+{
+	if (count < 3)
+		return false;
+
+	for (int i = 0 ; i < NUM_CHANNELS ; i++)
+	{
+		const double value = i < count ? values[i] : 1.0;
+		if (!(value >= 0.0 && value <= CALIBRATION_MAX_GAIN))
+			return false;
+		gains[i] = (uint8_t) lrint(value * CALIBRATION_GAIN_ONE);
+	}
+
+	return true;
+}
+
+
+calibration_t *
+calibration_load(
+	const char * const filename,
+	unsigned num_strips,
+	unsigned num_pixels,
+	bool rgbw
+)
+{
+	FILE * const file = fopen(filename, "r");
+	if (!file)
+		die("calibration: unable to open %s: %s\n", filename, strerror(errno));
+
+	calibration_t * const calibration = calibration_init(num_strips, num_pixels);
+
+	// pixel entries are applied after all the strip entries
+	// so they take precedence no matter where they appear
+	for (int pass = 0 ; pass < 2 ; pass++)
+	{
+		char line[256];
+		unsigned line_num = 0;
+
+		rewind(file);
+		while (fgets(line, sizeof(line), file))
+		{
+			line_num++;
+
+			char * const comment = strchr(line, '#');
+			if (comment)
+				*comment = '\0';
+
+			char kind[16];
+			if (sscanf(line, "%15s", kind) != 1)
+				continue;
+
+			unsigned strip, pixel;
+			double values[NUM_CHANNELS];
+			uint8_t gains[NUM_CHANNELS];
+			int count;
+
+			if (strcmp(kind, "strip") == 0)
+			{
+				count = sscanf(line, "%*s %u %lf %lf %lf %lf",
+					&strip, &values[0], &values[1], &values[2], &values[3]) - 1;
+				if (count < 0 || !calibration_parse_gains(values, count, gains) || strip >= LEDSCAPE_NUM_STRIPS)
+					die("calibration: %s:%u: invalid strip entry\n", filename, line_num);
+				if (pass != 0 || strip >= num_strips)
+					continue;
+
+				for (unsigned p = 0 ; p < num_pixels ; p++)
+					calibration_set_pixel(calibration, strip, p, gains, rgbw);
+			}
+			else if (strcmp(kind, "pixel") == 0)
+			{
+				count = sscanf(line, "%*s %u %u %lf %lf %lf %lf",
+					&strip, &pixel, &values[0], &values[1], &values[2], &values[3]) - 2;
+				if (count < 0 || !calibration_parse_gains(values, count, gains) || strip >= LEDSCAPE_NUM_STRIPS)
+					die("calibration: %s:%u: invalid pixel entry\n", filename, line_num);
+				// files made for longer strands are fine, just ignore the extra pixels
+				if (pass != 1 || strip >= num_strips || pixel >= num_pixels)
+					continue;
+
+				calibration_set_pixel(calibration, strip, pixel, gains, rgbw);
+			}
+			else
+			{
+				die("calibration: %s:%u: unknown entry '%s'\n", filename, line_num, kind);
+			}
+		}
+	}
+
+	fclose(file);
+	return calibration;
+}
+
+
+void
+calibration_apply(
+	const calibration_t * const calibration,
+	ledscape_frame_t * const out_frame,
+	const ledscape_frame_t * const in_frame
+)
+{
+	const uint8_t * in = (const uint8_t *) in_frame;
+	const uint8_t * gains = calibration->gains;
+	uint8_t * out = (uint8_t *) out_frame;
+	size_t len = calibration->frame_size;
+
+#ifdef __ARM_NEON__
+	// a frame row is a multiple of 8 strips * 4 bytes, so frames are always a multiple of 16 bytes
+	for ( ; len >= 16 ; len -= 16, in += 16, gains += 16, out += 16)
+	{
+		const uint8x16_t v = vld1q_u8(in);
+		const uint8x16_t g = vld1q_u8(gains);
+
+		// 8x8 -> 16 bit multiply, then saturating narrowing shift back to 8 bits
+		const uint16x8_t lo = vmull_u8(vget_low_u8(v), vget_low_u8(g));
+		const uint16x8_t hi = vmull_u8(vget_high_u8(v), vget_high_u8(g));
+
+		vst1q_u8(out, vcombine_u8(vqshrn_n_u16(lo, 7), vqshrn_n_u16(hi, 7)));
+	}
+#endif
+
+	for (size_t i = 0 ; i < len ; i++)
+	{
+		const unsigned v = (in[i] * gains[i]) >> 7;
+		out[i] = v > 255 ? 255 : v;
+	}
+}
+
+
+void
+calibration_close(
+	calibration_t * const calibration
+)
+{
+	free(calibration->gains);
+	free(calibration);
+}
@@ -0,0 +1,76 @@
+/** \file
+ * Per pixel brightness and tint calibration.
+ *
+ * Strips from different batches do not have the same brightness and
+ * white point. A calibration file gives every strip, or every pixel,
+ * a gain per color channel, which is applied when the frame is copied
+ * to the PRU.
+ *
+ * File format, one entry per line, '#' starts a comment:
+ *
+ *	strip <strip> <r> <g> <b> [w]
+ *	pixel <strip> <pixel> <r> <g> <b> [w]
+ *
+ * Gains are between 0.0 and 1.99, and default to 1.0. A pixel entry
+ * overrides the strip entry for that pixel, regardless of order.
+ */
+#ifndef _calibration_h_
+#define _calibration_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ledscape.h"
+
+/** Gains are stored in 1.7 fixed point, so 128 is a gain of 1.0 */
+#define CALIBRATION_GAIN_ONE 128
+
+typedef struct {
+	unsigned num_strips;
+	unsigned num_pixels;
+	size_t frame_size;
+
+	// one gain per byte of the frame, in the same order as the frame,
+	// so the kernel streams through both with no index math
+	uint8_t * gains;
+} calibration_t;
+
+
+/** Load a calibration file for frames of num_strips by num_pixels.
+ *
+ * rgbw selects which frame byte each of the r, g, b and w gains
+ * belongs to. Entries for strips or pixels outside of the frame are
+ * ignored. Exits on a malformed file.
+ */
+extern calibration_t *
+calibration_load(
+	const char * const filename,
+	unsigned num_strips,
+	unsigned num_pixels,
+	bool rgbw
+);
+
+/** Create a calibration with every gain set to 1.0 */
+extern calibration_t *
+calibration_init(
+	unsigned num_strips,
+	unsigned num_pixels
+);
+
+/** Write in * gains to out, saturating at 255.
+ *
+ * in and out are whole frames of calibration->num_strips by
+ * calibration->num_pixels, and may not overlap.
+ */
+extern void
+calibration_apply(
+	const calibration_t * const calibration,
+	ledscape_frame_t * const out,
+	const ledscape_frame_t * const in
+);
+
+extern void
+calibration_close(
+	calibration_t * const calibration
+);
+
+#endif
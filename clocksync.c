@@ -0,0 +1,118 @@
+/** \file
+ * Clock synchronization with a LedBurn sender, for presentation times.
+ */
+#include <string.h>
+#include <math.h>
+#include "clocksync.h"
+
+#define CLOCKSYNC_MAGIC "LBClock"
+#define CLOCKSYNC_FAST_INTERVAL_US 100000 // until the window is full
+
+
+bool
+clocksync_request_due(
+	const clocksync_t * const cs,
+	uint64_t now_us,
+	uint64_t interval_us
+)
+{
+	if (cs->num_samples < CLOCKSYNC_WINDOW)
+		interval_us = CLOCKSYNC_FAST_INTERVAL_US;
+	return now_us - cs->last_request_us >= interval_us;
+}
+
+
+size_t
+clocksync_make_request(
+	clocksync_t * const cs,
+	uint8_t * buf,
+	uint64_t now_us
+)
+{
+	memset(buf, 0, CLOCKSYNC_PACKET_SIZE);
+	memcpy(buf, CLOCKSYNC_MAGIC, 7);
+	buf[7] = CLOCKSYNC_REQUEST;
+
+	cs->seq++;
+	cs->last_request_us = now_us;
+	memcpy(buf + 8, &cs->seq, sizeof(cs->seq));
+	memcpy(buf + 16, &now_us, sizeof(now_us));
+
+	return CLOCKSYNC_PACKET_SIZE;
+}
+
+
+bool
+clocksync_is_packet(
+	const uint8_t * buf,
+	size_t len,
+	uint8_t type
+)
+{
+	return len == CLOCKSYNC_PACKET_SIZE
+		&& memcmp(buf, CLOCKSYNC_MAGIC, 7) == 0
+		&& buf[7] == type;
+}
+
+
+bool
+clocksync_handle_reply(
+	clocksync_t * const cs,
+	const uint8_t * buf,
+	uint64_t now_us
+)
+{
+	uint32_t seq;
+	int64_t t1, t2, t3;
+	memcpy(&seq, buf + 8, sizeof(seq));
+	memcpy(&t1, buf + 16, sizeof(t1));
+	memcpy(&t2, buf + 24, sizeof(t2));
+	memcpy(&t3, buf + 32, sizeof(t3));
+	const int64_t t4 = now_us;
+
+	// late replies to older requests may have been queued for long
+	if (seq != cs->seq || t1 != (int64_t) cs->last_request_us || t3 < t2)
+	{
+		cs->bad_replies++;
+		return false;
+	}
+
+	clocksync_sample_t * const sample = &cs->samples[cs->next_sample];
+	sample->offset_us = ((t2 - t1) + (t3 - t4)) / 2;
+	sample->delay_us = (t4 - t1) - (t3 - t2);
+	cs->next_sample = (cs->next_sample + 1) % CLOCKSYNC_WINDOW;
+	if (cs->num_samples < CLOCKSYNC_WINDOW)
+		cs->num_samples++;
+	cs->replies++;
+
+	const clocksync_sample_t * best = &cs->samples[0];
+	for (unsigned i = 1 ; i < cs->num_samples ; i++)
+		if (cs->samples[i].delay_us < best->delay_us)
+			best = &cs->samples[i];
+
+	double sum = 0;
+	for (unsigned i = 0 ; i < cs->num_samples ; i++)
+	{
+		const double diff = cs->samples[i].offset_us - best->offset_us;
+		sum += diff * diff;
+	}
+
+	cs->offset_us = best->offset_us;
+	cs->delay_us = best->delay_us;
+	cs->jitter_us = sqrt(sum / cs->num_samples);
+	cs->synced = true;
+	return true;
+}
+
+
+void
+clocksync_make_reply(
+	uint8_t * buf,
+	uint64_t received_us,
+	uint64_t now_us
+)
+{
+	buf[7] = CLOCKSYNC_REPLY;
+	memcpy(buf + 24, &received_us, sizeof(received_us));
+	memcpy(buf + 32, &now_us, sizeof(now_us));
+}
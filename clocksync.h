@@ -0,0 +1,125 @@
+/** \file
+ * Clock synchronization with a LedBurn sender, for presentation times.
+ *
+ * Controllers periodically send a request to the clock master (usually
+ * the sender), which answers with the times it received the request and
+ * sent the reply, on its own clock. As in NTP, with t1 and t4 the local
+ * send and receive times and t2 and t3 the master times:
+ *
+ *	offset = ((t2 - t1) + (t3 - t4)) / 2
+ *	delay  = (t4 - t1) - (t3 - t2)
+ *
+ * The offset of the sample with the lowest delay out of the last
+ * CLOCKSYNC_WINDOW is used, since queuing only ever adds delay. Jitter
+ * is the RMS deviation of the window's offsets from it.
+ *
+ * Packet, 40 bytes, little endian, times in microseconds:
+ *
+ *	offset  size  field
+ *	0       7     "LBClock"
+ *	7       1     type: 0 request, 1 reply
+ *	8       4     sequence number
+ *	12      4     reserved, 0
+ *	16      8     t1, controller clock (CLOCK_MONOTONIC)
+ *	24      8     t2, master clock (CLOCK_REALTIME), set in the reply
+ *	32      8     t3, master clock, set in the reply
+ */
+#ifndef _clocksync_h_
+#define _clocksync_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+#define CLOCKSYNC_PACKET_SIZE 40
+#define CLOCKSYNC_REQUEST 0
+#define CLOCKSYNC_REPLY 1
+#define CLOCKSYNC_WINDOW 8
+
+typedef struct {
+	int64_t offset_us;
+	int64_t delay_us;
+} clocksync_sample_t;
+
+typedef struct {
+	uint32_t seq;
+	uint64_t last_request_us;
+
+	clocksync_sample_t samples[CLOCKSYNC_WINDOW];
+	unsigned num_samples;
+	unsigned next_sample;
+
+	// estimates, valid once synced is set
+	bool synced;
+	int64_t offset_us; // master clock - local clock
+	int64_t delay_us; // round trip of the sample the offset came from
+	double jitter_us;
+
+	uint64_t replies;
+	uint64_t bad_replies;
+} clocksync_t;
+
+
+static inline uint64_t
+clocksync_now_us(
+	clockid_t clock
+) {
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/** Local (CLOCK_MONOTONIC) time of a master time, once synced */
+static inline uint64_t
+clocksync_to_local(
+	const clocksync_t * const cs,
+	uint64_t master_us
+) {
+	return master_us - cs->offset_us;
+}
+
+/** True if a request is due: quickly until synced, then every interval_us */
+extern bool
+clocksync_request_due(
+	const clocksync_t * const cs,
+	uint64_t now_us,
+	uint64_t interval_us
+);
+
+/** Fill a request packet in buf, which holds CLOCKSYNC_PACKET_SIZE bytes */
+extern size_t
+clocksync_make_request(
+	clocksync_t * const cs,
+	uint8_t * buf,
+	uint64_t now_us
+);
+
+/** True if buf holds a clock sync packet of the given type */
+extern bool
+clocksync_is_packet(
+	const uint8_t * buf,
+	size_t len,
+	uint8_t type
+);
+
+/** Update the estimates from a reply received at local time now_us.
+ *
+ * \returns false if the reply is not for our last request.
+ */
+extern bool
+clocksync_handle_reply(
+	clocksync_t * const cs,
+	const uint8_t * buf,
+	uint64_t now_us
+);
+
+/** Turn a request into its reply, in place, for the clock master */
+extern void
+clocksync_make_reply(
+	uint8_t * buf,
+	uint64_t received_us,
+	uint64_t now_us
+);
+
+#endif
@@ -0,0 +1,54 @@
+/** \file
+ * DDP (Distributed Display Protocol) receiver: data packet parsing.
+ */
+#include "ddp.h"
+
+// data type: custom, reserved, 3 bits of type, 3 bits of size
+#define DDP_TYPE(t) (((t) >> 3) & 0x07)
+#define DDP_SIZE(t) ((t) & 0x07)
+#define DDP_TYPE_UNDEFINED 0
+#define DDP_TYPE_RGB 1
+#define DDP_TYPE_RGBW 3
+#define DDP_SIZE_8_BITS 3
+
+
+bool
+ddp_parse(
+	const uint8_t * buf,
+	size_t len,
+	ddp_packet_t * const packet
+)
+{
+	if (len < DDP_HEADER_SIZE || (buf[0] & DDP_VERSION_MASK) != DDP_VERSION_1)
+		return false;
+
+	packet->flags = buf[0];
+	if (packet->flags & (DDP_FLAG_QUERY | DDP_FLAG_REPLY))
+		return false;
+	if (buf[3] != DDP_ID_DISPLAY && buf[3] != DDP_ID_ALL)
+		return false;
+
+	// senders that predate the type field send 0 or 1 for RGB
+	const uint8_t type = buf[2];
+	if (type == 0x00 || type == 0x01
+	|| (DDP_TYPE(type) == DDP_TYPE_RGB && DDP_SIZE(type) == DDP_SIZE_8_BITS)
+	|| (DDP_TYPE(type) == DDP_TYPE_UNDEFINED && DDP_SIZE(type) == DDP_SIZE_8_BITS))
+		packet->pixel_bytes = 3;
+	else if (DDP_TYPE(type) == DDP_TYPE_RGBW && DDP_SIZE(type) == DDP_SIZE_8_BITS)
+		packet->pixel_bytes = 4;
+	else
+		return false;
+
+	packet->sequence = buf[1] & 0x0F;
+	packet->offset = ((uint32_t)buf[4] << 24) | (buf[5] << 16) | (buf[6] << 8) | buf[7];
+	packet->length = (buf[8] << 8) | buf[9];
+
+	size_t header_size = DDP_HEADER_SIZE;
+	if (packet->flags & DDP_FLAG_TIMECODE)
+		header_size += DDP_TIMECODE_SIZE;
+	if (len < header_size || packet->length > len - header_size)
+		return false;
+	packet->data = buf + header_size;
+
+	return true;
+}
@@ -0,0 +1,52 @@
+/** \file
+ * DDP (Distributed Display Protocol) receiver: data packet parsing.
+ *
+ * A data packet carries a run of the display's bytes, at a byte offset
+ * from its first pixel, and the PUSH flag on the last packet of a frame
+ * shows it. Queries, replies and the control, config and status
+ * destinations are not for us.
+ */
+#ifndef _ddp_h_
+#define _ddp_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define DDP_PORT 4048
+#define DDP_HEADER_SIZE 10
+#define DDP_TIMECODE_SIZE 4
+
+#define DDP_FLAG_PUSH 0x01
+#define DDP_FLAG_QUERY 0x02
+#define DDP_FLAG_REPLY 0x04
+#define DDP_FLAG_STORAGE 0x08
+#define DDP_FLAG_TIMECODE 0x10
+#define DDP_VERSION_MASK 0xC0
+#define DDP_VERSION_1 0x40
+
+#define DDP_ID_DISPLAY 1
+#define DDP_ID_ALL 255
+
+typedef struct {
+	uint8_t flags;
+	uint8_t sequence; // 1 - 15, 0 if not used
+	unsigned pixel_bytes; // 3 for RGB, 4 for RGBW
+	uint32_t offset; // in bytes
+	const uint8_t * data;
+	uint16_t length;
+} ddp_packet_t;
+
+
+/** Parse a data packet for the display, of 8 bit RGB or RGBW pixels.
+ *
+ * \returns false for anything else, or malformed packets.
+ */
+extern bool
+ddp_parse(
+	const uint8_t * buf,
+	size_t len,
+	ddp_packet_t * const packet
+);
+
+#endif
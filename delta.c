@@ -0,0 +1,193 @@
+/** \file
+ * Reference frame cache for delta encoded LedBurn segments.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include "delta.h"
+#include "util.h"
+
+
+delta_t *
+delta_init(
+	unsigned num_strips,
+	size_t strip_size
+)
+{
+	delta_t * const delta = calloc(1, sizeof(*delta));
+	if (!delta)
+		die("delta: unable to allocate\n");
+
+	delta->num_strips = num_strips;
+	delta->strip_size = strip_size;
+	delta->ref = calloc(num_strips, strip_size);
+	delta->cur = calloc(num_strips, strip_size);
+	delta->cur_written = calloc(num_strips, sizeof(*delta->cur_written));
+	if (!delta->ref || !delta->cur || !delta->cur_written)
+		die("delta: unable to allocate %zu bytes\n", 2 * num_strips * strip_size);
+
+	return delta;
+}
+
+
+bool
+delta_decode_xor_rle(
+	const uint8_t * in,
+	size_t in_len,
+	const uint8_t * ref,
+	uint8_t * out,
+	size_t len
+)
+{
+	const uint8_t * const in_end = in + in_len;
+	const uint8_t * const out_end = out + len;
+
+	while (in < in_end)
+	{
+		const uint8_t control = *in++;
+
+		if (control & 0x80)
+		{
+			const size_t run = control - 0x7F;
+			if (run > (size_t)(out_end - out))
+				return false;
+			memcpy(out, ref, run);
+			out += run;
+			ref += run;
+			continue;
+		}
+
+		const size_t run = control + 1;
+		if (run > (size_t)(out_end - out) || run > (size_t)(in_end - in))
+			return false;
+		for (size_t i = 0 ; i < run ; i++)
+			out[i] = ref[i] ^ in[i];
+		in += run;
+		out += run;
+		ref += run;
+	}
+
+	return out == out_end;
+}
+
+
+size_t
+delta_encode_xor_rle(
+	const uint8_t * in,
+	const uint8_t * ref,
+	size_t len,
+	uint8_t * out
+)
+{
+	uint8_t * const out_start = out;
+	size_t i = 0;
+
+	while (i < len)
+	{
+		size_t run = 0;
+		while (i + run < len && run < 128 && in[i + run] == ref[i + run])
+			run++;
+		if (run)
+		{
+			*out++ = 0x7F + run;
+			i += run;
+			continue;
+		}
+
+		while (i + run < len && run < 128 && in[i + run] != ref[i + run])
+			run++;
+		*out++ = run - 1;
+		for (size_t j = 0 ; j < run ; j++)
+			*out++ = in[i + j] ^ ref[i + j];
+		i += run;
+	}
+
+	return out - out_start;
+}
+
+
+void
+delta_commit(
+	delta_t * const delta
+)
+{
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (unsigned s = 0 ; s < delta->num_strips ; s++)
+	{
+		if (!delta->cur_written[s])
+			continue;
+		const size_t offset = s * delta->strip_size;
+		memcpy(delta->ref + offset, delta->cur + offset, delta->strip_size);
+		delta->cur_written[s] = false;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	delta->decode_ns += (end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec);
+	delta->frames++;
+}
+
+
+void
+delta_ref_commit(
+	delta_ref_t * const ref,
+	bool complete
+)
+{
+	if (!ref->cur_painted)
+		return;
+
+	ref->ref_frame_id = ref->cur_frame_id;
+	ref->ref_valid = complete && !ref->cur_uncached;
+	ref->cur_painted = false;
+	ref->cur_uncached = false;
+}
+
+
+void
+delta_close(
+	delta_t * const delta
+)
+{
+	free(delta->ref);
+	free(delta->cur);
+	free(delta->cur_written);
+	free(delta);
+}
+
+
+void
+delta_print_stats(
+	const delta_t * const delta
+)
+{
+	const double saved = delta->raw_bytes ?
+		100.0 * (1.0 - (double) delta->wire_bytes / delta->raw_bytes) : 0;
+	const double decode_us = delta->frames ?
+		delta->decode_ns / 1e3 / delta->frames : 0;
+
+	printf("info: delta: %" PRIu64 " frames, %" PRIu64 " segments, %" PRIu64 " bytes received for %" PRIu64 " (%.1f%% saved), "
+		"%.1f us decode and commit per frame, %" PRIu64 " reference misses, %" PRIu64 " decode errors\n",
+		delta->frames,
+		delta->segments,
+		delta->wire_bytes,
+		delta->raw_bytes,
+		saved,
+		decode_us,
+		delta->ref_misses,
+		delta->decode_errors
+	);
+
+	if (delta->lz4_segments == 0)
+		return;
+	printf("info: lz4: %" PRIu64 " segments, %" PRIu64 " bytes decompressed to %" PRIu64 " (ratio %.2f), %.1f us decompress per frame\n",
+		delta->lz4_segments,
+		delta->lz4_wire_bytes,
+		delta->lz4_bytes,
+		delta->lz4_wire_bytes ? (double) delta->lz4_bytes / delta->lz4_wire_bytes : 0,
+		delta->frames ? delta->lz4_ns / 1e3 / delta->frames : 0
+	);
+}
@@ -0,0 +1,155 @@
+/** \file
+ * Reference frame cache for delta encoded LedBurn segments.
+ *
+ * A delta segment carries the XOR of its pixels with the same pixels of
+ * an earlier frame, run length encoded so unchanged bytes cost almost
+ * nothing on the wire. The receiver keeps the payload bytes of the last
+ * displayed frame (the reference) and of the frame being assembled, per
+ * strip, in the format they were sent.
+ *
+ * Encoding of the XOR stream, one control byte followed by data:
+ *
+ *	0x00 - 0x7F   n + 1 literal XOR bytes follow
+ *	0x80 - 0xFF   n - 0x7F bytes are unchanged, no data follows
+ */
+#ifndef _delta_h_
+#define _delta_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** A sender's frames in the reference.
+ *
+ * Senders paint their own strips, so the pixels are shared, but each
+ * numbers its own frames, and its delta segments refer to the last of
+ * its frames that was displayed.
+ */
+typedef struct {
+	uint32_t ref_frame_id;
+	uint32_t cur_frame_id; // set by the caller with every segment
+	bool cur_painted; // set by the caller with every segment
+	bool cur_uncached; // set by the caller when a segment of the frame could not be cached
+	bool ref_valid;
+} delta_ref_t;
+
+typedef struct {
+	unsigned num_strips;
+	size_t strip_size; // bytes cached per strip
+
+	// payload bytes of the last displayed frame, and the frame being assembled
+	uint8_t * ref;
+	uint8_t * cur;
+
+	// strips of cur written since the last commit. the others match ref
+	bool * cur_written;
+
+	// counters, never reset
+	uint64_t segments;
+	uint64_t wire_bytes; // encoded payload bytes received
+	uint64_t raw_bytes; // bytes the same segments take without encoding
+	uint64_t ref_misses; // segments against a reference we do not have
+	uint64_t decode_errors;
+	uint64_t decode_ns; // includes the commits
+	uint64_t frames;
+
+	// LZ4 compressed segments, decompressed before any delta decoding
+	uint64_t lz4_segments;
+	uint64_t lz4_wire_bytes;
+	uint64_t lz4_bytes;
+	uint64_t lz4_ns;
+} delta_t;
+
+
+extern delta_t *
+delta_init(
+	unsigned num_strips,
+	size_t strip_size
+);
+
+/** Bytes of one strip of the frame being assembled, to write to.
+ *
+ * The strip is copied to the reference when the frame is committed.
+ */
+static inline uint8_t *
+delta_cur_strip(
+	delta_t * const delta,
+	unsigned strip
+) {
+	delta->cur_written[strip] = true;
+	return delta->cur + strip * delta->strip_size;
+}
+
+/** Bytes of one strip of the reference frame */
+static inline const uint8_t *
+delta_ref_strip(
+	const delta_t * const delta,
+	unsigned strip
+) {
+	return delta->ref + strip * delta->strip_size;
+}
+
+/** Decode an XOR + RLE stream against ref into out.
+ *
+ * \returns false if the stream does not decode to exactly len bytes.
+ */
+extern bool
+delta_decode_xor_rle(
+	const uint8_t * in,
+	size_t in_len,
+	const uint8_t * ref,
+	uint8_t * out,
+	size_t len
+);
+
+/** The frame being assembled was displayed and becomes the reference.
+ *
+ * The next frame starts as a copy of it, since pixels that are not sent
+ * keep their value, so only the strips written since the last commit are
+ * copied. Commit the delta_ref_t of every sender with it.
+ */
+extern void
+delta_commit(
+	delta_t * const delta
+);
+
+/** The sender's strips of the frame being assembled were displayed.
+ *
+ * A frame that was displayed with segments missing, or with segments
+ * that were not cached, does not match what the sender has, so it is
+ * not a valid reference, and delta segments are refused until a complete
+ * frame is displayed. If the sender painted nothing since the last
+ * commit, its strips still hold its reference, which is kept.
+ */
+extern void
+delta_ref_commit(
+	delta_ref_t * const ref,
+	bool complete
+);
+
+/** Encode the XOR of in and ref, the inverse of delta_decode_xor_rle.
+ *
+ * out must hold 2 * len bytes, the worst case of alternating changed
+ * and unchanged bytes.
+ *
+ * \returns the number of bytes written to out.
+ */
+extern size_t
+delta_encode_xor_rle(
+	const uint8_t * in,
+	const uint8_t * ref,
+	size_t len,
+	uint8_t * out
+);
+
+extern void
+delta_close(
+	delta_t * const delta
+);
+
+extern void
+delta_print_stats(
+	const delta_t * const delta
+);
+
+#endif
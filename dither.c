@@ -0,0 +1,135 @@
+/** \file
+ * High bit depth frame cache with gamma and temporal dithering.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "dither.h"
+#include "util.h"
+
+
+dither_t *
+dither_init(
+	unsigned num_strips,
+	unsigned num_pixels,
+	double gamma
+)
+{
+	dither_t * const dither = calloc(1, sizeof(*dither));
+	if (!dither)
+		die("dither: unable to allocate\n");
+
+	dither->num_strips = num_strips;
+	dither->num_pixels = num_pixels;
+	dither->pixels = calloc(num_strips * num_pixels, sizeof(*dither->pixels));
+	dither->residual = calloc(num_strips * num_pixels, 3);
+	if (!dither->pixels || !dither->residual)
+		die("dither: unable to allocate %u pixels\n", num_strips * num_pixels);
+
+	dither->apply_gamma = (gamma != 1.0);
+	for (unsigned i = 0 ; i <= DITHER_GAMMA_LUT_SIZE ; i++)
+	{
+		const double in = (double) i / DITHER_GAMMA_LUT_SIZE;
+		dither->gamma_lut[i] = (uint16_t) lrint(pow(in, gamma) * 65535.0);
+	}
+
+	return dither;
+}
+
+
+/** Interpolate the gamma table between the two entries around v */
+static inline uint16_t
+dither_gamma(
+	const dither_t * const dither,
+	uint16_t v
+)
+{
+	const unsigned shift = 16 - DITHER_GAMMA_LUT_BITS;
+	const unsigned index = v >> shift;
+	const unsigned frac = v & ((1 << shift) - 1);
+	const unsigned lo = dither->gamma_lut[index];
+	const unsigned hi = dither->gamma_lut[index + 1];
+
+	return lo + (((hi - lo) * frac) >> shift);
+}
+
+
+/** Reduce one 16 bit channel to 8 bits, carrying the error in *residual */
+static inline uint8_t
+dither_channel(
+	unsigned v,
+	uint8_t * const residual
+)
+{
+	// scale 0..65535 to 0..(255 << 8), 8.8 fixed point
+	const unsigned x = v - (v >> 8) + *residual;
+	const unsigned out = x >> 8;
+
+	if (out > 255)
+	{
+		*residual = 0;
+		return 255;
+	}
+
+	*residual = x & 0xFF;
+	return out;
+}
+
+
+void
+dither_strip_to_frame(
+	dither_t * const dither,
+	ledscape_frame_t * const frame,
+	unsigned strip,
+	bool rgbw
+)
+{
+	const dither_pixel_t * const in = dither_strip(dither, strip);
+	uint8_t * residual = &dither->residual[strip * dither->num_pixels * 3];
+
+	for (unsigned i = 0 ; i < dither->num_pixels ; i++, residual += 3)
+	{
+		unsigned r = in[i].r;
+		unsigned g = in[i].g;
+		unsigned b = in[i].b;
+
+		if (dither->apply_gamma)
+		{
+			r = dither_gamma(dither, r);
+			g = dither_gamma(dither, g);
+			b = dither_gamma(dither, b);
+		}
+
+		const uint8_t r8 = dither_channel(r, &residual[0]);
+		const uint8_t g8 = dither_channel(g, &residual[1]);
+		const uint8_t b8 = dither_channel(b, &residual[2]);
+
+		if (rgbw)
+			ledscape_set_color_rgb_to_rgbw(frame, dither->num_strips, strip, i, r8, g8, b8);
+		else
+			ledscape_set_color(frame, dither->num_strips, COLOR_ORDER_BRG, strip, i, r8, g8, b8);
+	}
+}
+
+
+void
+dither_clear(
+	dither_t * const dither
+)
+{
+	const size_t count = dither->num_strips * dither->num_pixels;
+	memset(dither->pixels, 0, count * sizeof(*dither->pixels));
+	memset(dither->residual, 0, count * 3);
+}
+
+
+void
+dither_close(
+	dither_t * const dither
+)
+{
+	free(dither->pixels);
+	free(dither->residual);
+	free(dither);
+}
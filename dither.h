@@ -0,0 +1,95 @@
+/** \file
+ * High bit depth frame cache with gamma and temporal dithering.
+ *
+ * Keeps 16 bit per channel pixels for every strip, and reduces them
+ * to the 8 bit ledscape frame when a frame is sent to the PRU.
+ * The part of each channel that does not fit in 8 bits is carried
+ * over to the next frame (temporal error diffusion), so slow fades
+ * at low brightness do not band.
+ */
+#ifndef _dither_h_
+#define _dither_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ledscape.h"
+
+/** Number of entries in the gamma table.
+ *
+ * Indexed by the 12 most significant bits of the channel value and
+ * interpolated, so the table stays small enough for the L1 cache.
+ */
+#define DITHER_GAMMA_LUT_BITS 12
+#define DITHER_GAMMA_LUT_SIZE (1 << DITHER_GAMMA_LUT_BITS)
+
+typedef struct {
+	uint16_t r;
+	uint16_t g;
+	uint16_t b;
+} __attribute__((__packed__)) dither_pixel_t;
+
+typedef struct {
+	// also the width of the frames written by dither_strip_to_frame()
+	unsigned num_strips;
+	unsigned num_pixels;
+
+	// strip-major: pixel p of strip s is at pixels[s * num_pixels + p]
+	dither_pixel_t * pixels;
+
+	// error left over from the previous frame, in 1/256 of an 8 bit step
+	uint8_t * residual;
+
+	bool apply_gamma;
+	uint16_t gamma_lut[DITHER_GAMMA_LUT_SIZE + 1];
+} dither_t;
+
+
+extern dither_t *
+dither_init(
+	unsigned num_strips,
+	unsigned num_pixels,
+	double gamma
+);
+
+/** The cached high depth pixels of one strip */
+static inline dither_pixel_t *
+dither_strip(
+	dither_t * const dither,
+	unsigned strip
+) {
+	return &dither->pixels[strip * dither->num_pixels];
+}
+
+/** Expand a 12 bit channel value to the full 16 bit range */
+static inline uint16_t
+dither_expand12(
+	uint16_t v
+) {
+	return (v << 4) | (v >> 8);
+}
+
+/** Apply gamma, then dither one strip of the cache into an 8 bit frame.
+ *
+ * When rgbw is set the result is written as RGBW with the white
+ * channel extracted, as for an 8 bit RGB payload.
+ */
+extern void
+dither_strip_to_frame(
+	dither_t * const dither,
+	ledscape_frame_t * const frame,
+	unsigned strip,
+	bool rgbw
+);
+
+/** Zero the cached pixels and the carried error of every strip */
+extern void
+dither_clear(
+	dither_t * const dither
+);
+
+extern void
+dither_close(
+	dither_t * const dither
+);
+
+#endif
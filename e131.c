@@ -0,0 +1,270 @@
+/** \file
+ * sACN (E1.31) receiver: packet parsing, and the per universe merge of
+ * several sources by priority.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "e131.h"
+#include "util.h"
+
+#ifdef __ARM_NEON__
+#include <arm_neon.h>
+#endif
+
+// root layer
+#define E131_ACN_ID "ASC-E1.17\0\0\0"
+#define E131_VECTOR_ROOT_DATA 0x00000004
+#define E131_VECTOR_ROOT_EXTENDED 0x00000008
+// framing layer
+#define E131_VECTOR_DATA_PACKET 0x00000002
+#define E131_VECTOR_EXTENDED_SYNC 0x00000001
+// dmp layer
+#define E131_VECTOR_DMP_SET_PROPERTY 0x02
+#define E131_DMP_ADDRESS_TYPE 0xA1
+
+#define E131_DATA_HEADER_SIZE 126 // up to the first channel, after the start code
+#define E131_SYNC_PACKET_SIZE 49
+
+static inline uint16_t
+get16(const uint8_t * p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+static inline uint32_t
+get32(const uint8_t * p)
+{
+	return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+
+bool
+e131_parse(
+	const uint8_t * buf,
+	size_t len,
+	e131_packet_t * const packet
+)
+{
+	if (len < E131_SYNC_PACKET_SIZE
+	|| get16(buf) != 0x0010 // preamble size
+	|| memcmp(buf + 4, E131_ACN_ID, 12) != 0)
+		return false;
+
+	const uint32_t root_vector = get32(buf + 18);
+	packet->cid = buf + 22;
+	packet->sequence = buf[44];
+
+	if (root_vector == E131_VECTOR_ROOT_EXTENDED)
+	{
+		// universe discovery is extended too, but not for us
+		if (get32(buf + 40) != E131_VECTOR_EXTENDED_SYNC)
+			return false;
+		packet->type = E131_SYNC;
+		packet->sync_universe = get16(buf + 45);
+		return true;
+	}
+
+	if (root_vector != E131_VECTOR_ROOT_DATA
+	|| len < E131_DATA_HEADER_SIZE
+	|| get32(buf + 40) != E131_VECTOR_DATA_PACKET
+	|| buf[117] != E131_VECTOR_DMP_SET_PROPERTY
+	|| buf[118] != E131_DMP_ADDRESS_TYPE
+	|| buf[125] != 0) // only the null start code carries levels
+		return false;
+
+	const uint16_t count = get16(buf + 123); // including the start code
+	if (count < 1 || count > 513 || (size_t)(count - 1) > len - E131_DATA_HEADER_SIZE)
+		return false;
+
+	packet->type = E131_DATA;
+	packet->priority = buf[108];
+	packet->sync_universe = get16(buf + 109);
+	packet->sequence = buf[111];
+	packet->options = buf[112];
+	packet->universe = get16(buf + 113);
+	packet->data = buf + E131_DATA_HEADER_SIZE;
+	packet->length = count - 1;
+	return packet->universe != 0 && packet->universe <= E131_MAX_UNIVERSE;
+}
+
+
+void
+e131_multicast_group(
+	uint16_t universe,
+	char group[16]
+)
+{
+	snprintf(group, 16, "239.255.%u.%u", universe >> 8, universe & 0xFF);
+}
+
+
+e131_merge_t *
+e131_merge_init(
+	unsigned num_universes,
+	e131_merge_policy_t policy
+)
+{
+	e131_merge_t * const merge = calloc(1, sizeof(*merge));
+	if (!merge)
+		die("e131: unable to allocate\n");
+	merge->num_universes = num_universes;
+	merge->policy = policy;
+	merge->universes = calloc(num_universes, sizeof(*merge->universes));
+	if (!merge->universes)
+		die("e131: unable to allocate %u universes\n", num_universes);
+	return merge;
+}
+
+
+// out = max(out, in), channel by channel
+static void
+e131_htp(
+	uint8_t * out,
+	const uint8_t * in,
+	unsigned len
+)
+{
+	unsigned i = 0;
+#ifdef __ARM_NEON__
+	for ( ; i + 16 <= len ; i += 16)
+		vst1q_u8(out + i, vmaxq_u8(vld1q_u8(out + i), vld1q_u8(in + i)));
+#endif
+	for ( ; i < len ; i++)
+		out[i] = in[i] > out[i] ? in[i] : out[i];
+}
+
+
+static e131_source_t *
+e131_find_source(
+	e131_universe_t * const universe,
+	const uint8_t * cid,
+	uint64_t now_us
+)
+{
+	e131_source_t * free_source = NULL;
+	for (unsigned s = 0 ; s < E131_MAX_SOURCES ; s++)
+	{
+		e131_source_t * const source = &universe->sources[s];
+		if (source->in_use && now_us - source->last_us > E131_SOURCE_TIMEOUT_US)
+			source->in_use = false;
+		if (!source->in_use) {
+			if (!free_source)
+				free_source = source;
+			continue;
+		}
+		if (memcmp(source->cid, cid, E131_CID_SIZE) == 0)
+			return source;
+	}
+
+	if (free_source) {
+		memcpy(free_source->cid, cid, E131_CID_SIZE);
+		free_source->in_use = true;
+	}
+	return free_source;
+}
+
+
+const uint8_t *
+e131_merge(
+	e131_merge_t * const merge,
+	unsigned index,
+	const e131_packet_t * const packet,
+	uint64_t now_us,
+	uint16_t * const length,
+	bool * const lead
+)
+{
+	*lead = false;
+	if (index >= merge->num_universes || (packet->options & E131_OPTION_PREVIEW))
+		return NULL;
+	merge->packets++;
+
+	e131_universe_t * const universe = &merge->universes[index];
+	e131_source_t * const sender = e131_find_source(universe, packet->cid, now_us);
+	if (!sender) {
+		merge->dropped++;
+		return NULL;
+	}
+
+	if (packet->options & E131_OPTION_TERMINATED) {
+		sender->in_use = false;
+	} else {
+		sender->priority = packet->priority;
+		sender->last_us = now_us;
+		memcpy(sender->data, packet->data, packet->length);
+		if (sender->length > packet->length)
+			memset(sender->data + packet->length, 0, sender->length - packet->length);
+		sender->length = packet->length;
+	}
+
+	// the sources with the highest priority drive the universe. the first of them leads it
+	e131_source_t * winners[E131_MAX_SOURCES];
+	unsigned num_winners = 0;
+	for (unsigned s = 0 ; s < E131_MAX_SOURCES ; s++)
+	{
+		e131_source_t * const source = &universe->sources[s];
+		if (source->in_use && now_us - source->last_us > E131_SOURCE_TIMEOUT_US)
+			source->in_use = false;
+		if (!source->in_use)
+			continue;
+		if (num_winners > 0 && source->priority < winners[0]->priority)
+			continue;
+		if (num_winners > 0 && source->priority > winners[0]->priority)
+			num_winners = 0;
+		winners[num_winners++] = source;
+	}
+
+	bool driving = false;
+	for (unsigned w = 0 ; w < num_winners ; w++)
+		driving |= winners[w] == sender;
+	if (num_winners == 0 || (!driving && sender->in_use))
+		return NULL;
+	*lead = winners[0] == sender;
+
+	if (num_winners == 1 || (merge->policy == E131_MERGE_LTP && sender->in_use)) {
+		const e131_source_t * const source = sender->in_use ? sender : winners[0];
+		*length = source->length;
+		return source->data;
+	}
+	if (merge->policy == E131_MERGE_LTP) {
+		// the last source terminated. the lead takes over
+		*length = winners[0]->length;
+		return winners[0]->data;
+	}
+
+	merge->merges++;
+	*length = winners[0]->length;
+	memcpy(universe->merged, winners[0]->data, sizeof(universe->merged));
+	for (unsigned w = 1 ; w < num_winners ; w++)
+	{
+		e131_htp(universe->merged, winners[w]->data, sizeof(universe->merged));
+		if (winners[w]->length > *length)
+			*length = winners[w]->length;
+	}
+	return universe->merged;
+}
+
+
+void
+e131_print_stats(
+	const e131_merge_t * const merge
+)
+{
+	printf("info: e131: %" PRIu64 " packets, %" PRIu64 " merged with other sources, %" PRIu64 " from too many sources\n",
+		merge->packets,
+		merge->merges,
+		merge->dropped
+	);
+}
+
+
+void
+e131_merge_close(
+	e131_merge_t * const merge
+)
+{
+	free(merge->universes);
+	free(merge);
+}
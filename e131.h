@@ -0,0 +1,131 @@
+/** \file
+ * sACN (E1.31) receiver: packet parsing, and the per universe merge of
+ * several sources by priority.
+ *
+ * Every universe keeps the last data of up to E131_MAX_SOURCES sources
+ * (consoles, told apart by their CID). Only the sources with the highest
+ * priority drive the universe. When several share it, HTP takes the
+ * highest value of every channel, and LTP the data of whichever source
+ * sent last. A source that stops sending for 2.5 seconds, or terminates
+ * its stream, no longer counts.
+ *
+ * Universes are mapped onto strips by a universe_map_t, see universe.h.
+ */
+#ifndef _e131_h_
+#define _e131_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define E131_PORT 5568
+#define E131_MAX_UNIVERSE 63999
+#define E131_MAX_SOURCES 4
+#define E131_SOURCE_TIMEOUT_US 2500000
+#define E131_CID_SIZE 16
+
+typedef enum {
+	E131_DATA,
+	E131_SYNC,
+} e131_packet_type_t;
+
+typedef struct {
+	e131_packet_type_t type;
+	const uint8_t * cid;
+	uint8_t priority;
+	uint8_t sequence;
+	uint8_t options;
+	uint16_t universe; // of a data packet
+	uint16_t sync_universe; // the universe of the syncs that commit a data packet, or of a sync packet. 0 if none
+	const uint8_t * data; // without the start code
+	uint16_t length;
+} e131_packet_t;
+
+#define E131_OPTION_TERMINATED 0x40
+#define E131_OPTION_PREVIEW 0x80
+
+typedef enum {
+	E131_MERGE_HTP,
+	E131_MERGE_LTP,
+} e131_merge_policy_t;
+
+typedef struct {
+	bool in_use;
+	uint8_t cid[E131_CID_SIZE];
+	uint8_t priority;
+	uint64_t last_us;
+	uint8_t data[512]; // zero beyond the length the source sent
+	uint16_t length;
+} e131_source_t;
+
+typedef struct {
+	e131_source_t sources[E131_MAX_SOURCES];
+	uint8_t merged[512];
+} e131_universe_t;
+
+typedef struct {
+	unsigned num_universes;
+	e131_merge_policy_t policy;
+	e131_universe_t * universes;
+
+	// counters
+	uint64_t packets;
+	uint64_t merges; // packets that were merged with other sources
+	uint64_t dropped; // of sources beyond E131_MAX_SOURCES
+} e131_merge_t;
+
+
+/** Parse a data or a sync packet, of the stream or the discovery of
+ * universes.
+ *
+ * \returns false for anything else, or malformed packets.
+ */
+extern bool
+e131_parse(
+	const uint8_t * buf,
+	size_t len,
+	e131_packet_t * const packet
+);
+
+/** The multicast group of a universe, 239.255.<high byte>.<low byte> */
+extern void
+e131_multicast_group(
+	uint16_t universe,
+	char group[16]
+);
+
+extern e131_merge_t *
+e131_merge_init(
+	unsigned num_universes,
+	e131_merge_policy_t policy
+);
+
+/** Merge a data packet into universe index.
+ *
+ * \returns the channels to paint and their number in length, or NULL
+ * if the packet doesn't change the universe (a lower priority source).
+ * lead is set when the packet's source leads the universe, which is the
+ * first of the sources with the highest priority, so a frame counts
+ * every universe once whatever the number of sources.
+ */
+extern const uint8_t *
+e131_merge(
+	e131_merge_t * const merge,
+	unsigned index,
+	const e131_packet_t * const packet,
+	uint64_t now_us,
+	uint16_t * const length,
+	bool * const lead
+);
+
+extern void
+e131_print_stats(
+	const e131_merge_t * const merge
+);
+
+extern void
+e131_merge_close(
+	e131_merge_t * const merge
+);
+
+#endif
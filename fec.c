@@ -0,0 +1,245 @@
+/** \file
+ * XOR parity forward error correction for LedBurn frames.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "fec.h"
+#include "util.h"
+
+
+fec_t *
+fec_init(
+	unsigned max_segments,
+	size_t arena_size
+)
+{
+	fec_t * const fec = calloc(1, sizeof(*fec));
+	if (!fec)
+		die("fec: unable to allocate\n");
+
+	fec->max_segments = max_segments;
+	fec->gen = 1;
+	fec->arena_size = arena_size;
+	fec->arena = malloc(arena_size);
+	fec->data = calloc(max_segments, sizeof(*fec->data));
+	fec->parity = calloc(max_segments, sizeof(*fec->parity));
+	fec->group_size = calloc(max_segments, sizeof(*fec->group_size));
+	fec->groups = calloc(max_segments, sizeof(*fec->groups));
+	if (!fec->arena || !fec->data || !fec->parity || !fec->group_size || !fec->groups)
+		die("fec: unable to allocate %zu bytes\n", arena_size);
+
+	return fec;
+}
+
+
+static bool
+fec_store(
+	fec_t * const fec,
+	fec_entry_t * const entry,
+	const uint8_t * buf,
+	size_t len
+)
+{
+	if (entry->gen == fec->gen)
+		return true; // duplicate
+	if (fec->arena_used + len > fec->arena_size)
+	{
+		fec->arena_full++;
+		return false;
+	}
+
+	memcpy(fec->arena + fec->arena_used, buf, len);
+	entry->gen = fec->gen;
+	entry->offset = fec->arena_used;
+	entry->len = len;
+	fec->arena_used += len;
+	return true;
+}
+
+
+void
+fec_add_data(
+	fec_t * const fec,
+	unsigned seg_id,
+	const uint8_t * buf,
+	size_t len
+)
+{
+	if (seg_id >= fec->max_segments)
+		return;
+	fec_store(fec, &fec->data[seg_id], buf, len);
+}
+
+
+void
+fec_add_parity(
+	fec_t * const fec,
+	unsigned first,
+	unsigned k,
+	const uint8_t * payload,
+	size_t len
+)
+{
+	if (k == 0 || first + k > fec->max_segments)
+		return;
+	if (fec->parity[first].gen == fec->gen)
+		return; // duplicate
+	if (!fec_store(fec, &fec->parity[first], payload, len))
+		return;
+
+	fec->group_size[first] = k;
+	fec->groups[fec->num_groups++] = first;
+	fec->parity_segments++;
+}
+
+
+int
+fec_group_of(
+	const fec_t * const fec,
+	unsigned seg_id
+)
+{
+	// groups are few per frame, so a scan is cheaper than a per segment table to clear
+	for (unsigned g = 0 ; g < fec->num_groups ; g++)
+	{
+		const unsigned first = fec->groups[g];
+		if (seg_id >= first && seg_id < first + fec->group_size[first])
+			return first;
+	}
+	return -1;
+}
+
+
+size_t
+fec_recover(
+	fec_t * const fec,
+	unsigned first,
+	uint8_t * out
+)
+{
+	const fec_entry_t * const parity = &fec->parity[first];
+	if (parity->gen != fec->gen)
+		return 0;
+	const unsigned k = fec->group_size[first];
+
+	int missing = -1;
+	for (unsigned i = first ; i < first + k ; i++)
+	{
+		if (fec->data[i].gen == fec->gen)
+			continue;
+		if (missing >= 0)
+			return 0; // more than one. maybe later
+		missing = i;
+	}
+	if (missing < 0)
+		return 0;
+
+	// the block goes after the magic, so out is the datagram once it is done
+	uint8_t * const block = out + FEC_MAGIC_SIZE - FEC_LENGTH_SIZE;
+	if (parity->len < FEC_LENGTH_SIZE || parity->len > 65536 - FEC_MAGIC_SIZE + FEC_LENGTH_SIZE)
+		return 0;
+	memcpy(block, fec->arena + parity->offset, parity->len);
+
+	for (unsigned i = first ; i < first + k ; i++)
+	{
+		if ((int) i == missing)
+			continue;
+		const fec_entry_t * const data = &fec->data[i];
+		const uint8_t * const datagram = fec->arena + data->offset;
+		if (data->len < FEC_MAGIC_SIZE || data->len - FEC_MAGIC_SIZE + FEC_LENGTH_SIZE > parity->len)
+			return 0; // the parity does not cover this block
+
+		const uint16_t len = data->len - FEC_MAGIC_SIZE;
+		block[0] ^= len & 0xFF;
+		block[1] ^= len >> 8;
+		for (unsigned j = 0 ; j < len ; j++)
+			block[FEC_LENGTH_SIZE + j] ^= datagram[FEC_MAGIC_SIZE + j];
+	}
+
+	const size_t len = block[0] | (block[1] << 8);
+	if (len + FEC_LENGTH_SIZE > parity->len)
+		return 0;
+
+	memcpy(out, "LedBurn", FEC_MAGIC_SIZE);
+	fec->recovered++;
+	return len + FEC_MAGIC_SIZE;
+}
+
+
+size_t
+fec_parity(
+	const uint8_t * const * datagrams,
+	const size_t * lens,
+	unsigned k,
+	uint8_t * out
+)
+{
+	size_t parity_len = 0;
+	for (unsigned i = 0 ; i < k ; i++)
+		if (lens[i] - FEC_MAGIC_SIZE + FEC_LENGTH_SIZE > parity_len)
+			parity_len = lens[i] - FEC_MAGIC_SIZE + FEC_LENGTH_SIZE;
+	memset(out, 0, parity_len);
+
+	for (unsigned i = 0 ; i < k ; i++)
+	{
+		const uint16_t len = lens[i] - FEC_MAGIC_SIZE;
+		out[0] ^= len & 0xFF;
+		out[1] ^= len >> 8;
+		for (unsigned j = 0 ; j < len ; j++)
+			out[FEC_LENGTH_SIZE + j] ^= datagrams[i][FEC_MAGIC_SIZE + j];
+	}
+
+	return parity_len;
+}
+
+
+void
+fec_end_frame(
+	fec_t * const fec
+)
+{
+	for (unsigned g = 0 ; g < fec->num_groups ; g++)
+	{
+		const unsigned first = fec->groups[g];
+		unsigned missing = 0;
+		for (unsigned i = first ; i < first + fec->group_size[first] ; i++)
+			if (fec->data[i].gen != fec->gen)
+				missing++;
+		if (missing > 1)
+			fec->unrecoverable += missing;
+	}
+
+	fec->gen++;
+	fec->num_groups = 0;
+	fec->arena_used = 0;
+}
+
+
+void
+fec_close(
+	fec_t * const fec
+)
+{
+	free(fec->arena);
+	free(fec->data);
+	free(fec->parity);
+	free(fec->group_size);
+	free(fec->groups);
+	free(fec);
+}
+
+
+void
+fec_print_stats(
+	const fec_t * const fec
+)
+{
+	printf("info: fec: %" PRIu64 " parity segments, %" PRIu64 " segments recovered, %" PRIu64 " unrecoverable, %" PRIu64 " not kept (arena full)\n",
+		fec->parity_segments,
+		fec->recovered,
+		fec->unrecoverable,
+		fec->arena_full
+	);
+}
@@ -0,0 +1,130 @@
+/** \file
+ * XOR parity forward error correction for LedBurn frames.
+ *
+ * A parity segment protects a group of K consecutive data segments of a
+ * frame. Each data segment is protected as a block made of the datagram
+ * length less 7 (2 bytes, little endian) followed by the datagram from
+ * byte 7 on, zero padded to the longest block of the group; the parity
+ * payload is the XOR of the blocks. When exactly one data segment of a
+ * group is missing, XOR-ing the parity with the other blocks gives back
+ * its block, and "LedBurn" followed by the block is the lost datagram.
+ *
+ * The datagrams of the frame being received are kept in an arena, and
+ * entries are tagged with a frame generation so nothing has to be
+ * cleared between frames.
+ */
+#ifndef _fec_h_
+#define _fec_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define FEC_MAGIC_SIZE 7 // "LedBurn", not part of the protected block
+#define FEC_LENGTH_SIZE 2
+
+typedef struct {
+	uint32_t gen; // entry is valid when it matches the fec generation
+	uint32_t offset; // in the arena
+	uint16_t len;
+} fec_entry_t;
+
+typedef struct {
+	unsigned max_segments;
+	uint32_t gen;
+
+	uint8_t * arena;
+	size_t arena_size;
+	size_t arena_used;
+
+	fec_entry_t * data; // by segment id
+	fec_entry_t * parity; // by the first segment id of the group
+	uint16_t * group_size; // by the first segment id of the group
+	uint32_t * groups; // first segment ids of the parity groups of this frame
+	unsigned num_groups;
+
+	uint64_t parity_segments;
+	uint64_t recovered;
+	uint64_t unrecoverable; // lost data segments in groups that lost more than one
+	uint64_t arena_full;
+} fec_t;
+
+
+extern fec_t *
+fec_init(
+	unsigned max_segments,
+	size_t arena_size
+);
+
+/** Keep a data segment datagram of the current frame */
+extern void
+fec_add_data(
+	fec_t * const fec,
+	unsigned seg_id,
+	const uint8_t * buf,
+	size_t len
+);
+
+/** Keep a parity segment payload for segments first .. first + k - 1 */
+extern void
+fec_add_parity(
+	fec_t * const fec,
+	unsigned first,
+	unsigned k,
+	const uint8_t * payload,
+	size_t len
+);
+
+/** The first segment id of the parity group holding seg_id, or -1 if no
+ * parity for it was received yet.
+ */
+extern int
+fec_group_of(
+	const fec_t * const fec,
+	unsigned seg_id
+);
+
+/** Rebuild the missing data segment of a group, if exactly one is missing.
+ *
+ * out must hold 65536 bytes.
+ *
+ * \returns the length of the rebuilt datagram, or 0.
+ */
+extern size_t
+fec_recover(
+	fec_t * const fec,
+	unsigned first,
+	uint8_t * out
+);
+
+/** Build the parity payload of k datagrams, as a sender does.
+ *
+ * out must hold the longest datagram length less 5 bytes.
+ *
+ * \returns the parity payload length.
+ */
+extern size_t
+fec_parity(
+	const uint8_t * const * datagrams,
+	const size_t * lens,
+	unsigned k,
+	uint8_t * out
+);
+
+/** Count the unrecoverable segments of the frame, and start a new one */
+extern void
+fec_end_frame(
+	fec_t * const fec
+);
+
+extern void
+fec_close(
+	fec_t * const fec
+);
+
+extern void
+fec_print_stats(
+	const fec_t * const fec
+);
+
+#endif
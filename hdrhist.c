@@ -0,0 +1,65 @@
+/** \file
+ * Log-linear (HDR style) histograms of durations.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "hdrhist.h"
+
+
+// the largest value of a bucket
+static uint64_t
+hdrhist_bucket_top(
+	unsigned bucket
+)
+{
+	if (bucket < (1u << HDRHIST_SUB_BITS))
+		return bucket;
+	const unsigned shift = (bucket >> HDRHIST_SUB_BITS) - 1;
+	const uint64_t low = (uint64_t)((1u << HDRHIST_SUB_BITS) + (bucket & ((1u << HDRHIST_SUB_BITS) - 1))) << shift;
+	return low + (1ull << shift) - 1;
+}
+
+
+uint64_t
+hdrhist_percentile(
+	const hdrhist_t * const hist,
+	double fraction
+)
+{
+	if (hist->total == 0)
+		return 0;
+	const uint64_t rank = (uint64_t)(fraction * hist->total + 0.5);
+	uint64_t seen = 0;
+	for (unsigned b = 0 ; b < HDRHIST_BUCKETS ; b++) {
+		seen += hist->counts[b];
+		if (seen >= rank && seen > 0) {
+			const uint64_t top = hdrhist_bucket_top(b);
+			return top < hist->max ? top : hist->max;
+		}
+	}
+	return hist->max;
+}
+
+
+void
+hdrhist_print(
+	const hdrhist_t * const hist,
+	const char * name
+)
+{
+	printf("%s: %" PRIu64 " samples, p50 %" PRIu64 " p90 %" PRIu64 " p99 %" PRIu64 " p99.9 %" PRIu64 " max %" PRIu64 " us\n",
+		name, hist->total,
+		hdrhist_percentile(hist, 0.5), hdrhist_percentile(hist, 0.9),
+		hdrhist_percentile(hist, 0.99), hdrhist_percentile(hist, 0.999),
+		hist->max);
+}
+
+
+void
+hdrhist_reset(
+	hdrhist_t * const hist
+)
+{
+	memset(hist, 0, sizeof(*hist));
+}
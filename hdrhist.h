@@ -0,0 +1,75 @@
+/** \file
+ * Log-linear (HDR style) histograms of durations.
+ *
+ * Values below 2^HDRHIST_SUB_BITS have a bucket each; above, every power
+ * of two is split in 2^HDRHIST_SUB_BITS buckets of equal width, so a
+ * bucket is within 1/16 of the values it holds from microseconds to
+ * minutes, in a fixed 1.6 KB without allocation. Recording is a couple of
+ * instructions, and the percentiles are read from the buckets when they
+ * are printed.
+ */
+#ifndef _hdrhist_h_
+#define _hdrhist_h_
+
+#include <stdint.h>
+
+#define HDRHIST_SUB_BITS 4
+#define HDRHIST_MAX_BITS 28 // values are clamped to 2^28 - 1: 4.5 minutes in microseconds, 268 ms in nanoseconds
+#define HDRHIST_BUCKETS ((HDRHIST_MAX_BITS - HDRHIST_SUB_BITS + 1) << HDRHIST_SUB_BITS)
+
+typedef struct {
+	uint32_t counts[HDRHIST_BUCKETS];
+	uint64_t total;
+	uint64_t max;
+} hdrhist_t;
+
+
+static inline unsigned
+hdrhist_bucket(
+	uint64_t value
+)
+{
+	if (value < (1u << HDRHIST_SUB_BITS))
+		return value;
+	if (value >= (1u << HDRHIST_MAX_BITS))
+		value = (1u << HDRHIST_MAX_BITS) - 1;
+	const unsigned shift = 63 - __builtin_clzll(value) - HDRHIST_SUB_BITS;
+	return ((shift + 1) << HDRHIST_SUB_BITS) + ((value >> shift) & ((1u << HDRHIST_SUB_BITS) - 1));
+}
+
+static inline void
+hdrhist_record(
+	hdrhist_t * const hist,
+	uint64_t value
+)
+{
+	hist->counts[hdrhist_bucket(value)]++;
+	hist->total++;
+	if (value > hist->max)
+		hist->max = value;
+}
+
+/** The value below which the fraction of the recorded values is, rounded
+ * up to the top of its bucket. 0 if nothing was recorded.
+ */
+extern uint64_t
+hdrhist_percentile(
+	const hdrhist_t * const hist,
+	double fraction
+);
+
+/** Print the count, 50th, 90th, 99th and 99.9th percentiles and the
+ * maximum, in microseconds, on a line starting with name.
+ */
+extern void
+hdrhist_print(
+	const hdrhist_t * const hist,
+	const char * name
+);
+
+extern void
+hdrhist_reset(
+	hdrhist_t * const hist
+);
+
+#endif
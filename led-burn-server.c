@@ -1,346 +1,3260 @@
-/** \file
-*  	LedBurn protocol server for beagle bone black.
-*	Receive udp packets with LedBurn protocol data, and sends it to ws281x led pixels
-*/
-#include <stdio.h>
-#include <stdlib.h>
-#include <unistd.h>
-#include <limits.h>
-#include <stdint.h>
-#include <ctype.h>
-#include <stdbool.h>
-#include <sys/types.h>
-#include <netinet/in.h>
-#include <inttypes.h>
-#include <errno.h>
-#include <string.h>
-#include <math.h>
-#include <ifaddrs.h>
-#include <net/if.h>
-#include <fcntl.h>
-#include "ledscape.h"
-
-#define min(a, b) ((a) < (b) ? (a) : (b))
-
-#define MAX_SUPPORTED_PIXELS_PER_STRAND 1500
-#define DEFAULT_MAX_PIXELS 600
-#define LB_HEADER_SIZE (8+8+8)
-
-int pixelsPerStrand = DEFAULT_MAX_PIXELS;
-
-// we support up to 4096 segments, or 64 segments per strip if all strips are used, which is 10 pixels per packet.
-// this is more than enough
-#define MAX_SUPPORTED_SEGMENTS (LEDSCAPE_NUM_STRIPS * 64)
-bool receivedSegArr[MAX_SUPPORTED_SEGMENTS] = {false};
-uint32_t currentFrame = 0;
-uint32_t numOfReceivedSegments = 0;
-
-// framerate protection
-bool fullFrameReady = false;
-
-// LedScape things
-ledscape_t *leds = NULL;
-uint8_t buffer_index = 0;
-ledscape_frame_t *frame = NULL;
-
-typedef struct PacketHeaderData
-{
-  uint32_t frameId;
-  uint32_t segInFrame;
-  uint32_t currSegId;
-  uint16_t stripId;
-  uint16_t pixelId;
-  uint16_t numOfPixels; // this is not actually header data, but it's nice to have it here
-} PacketHeaderData;
-
-void ChangeLedScapeBuffers()
-{
-	buffer_index = (buffer_index+1)%2;
-	frame = ledscape_frame(leds, buffer_index);
-}
-
-void SendColorsToStrips()
-{
-	// Wait for previous send to complete if still in progress
-	ledscape_wait(leds);
-	
-	// the following line is critical for the leds to have proper display.
-	// if it is absent, the leds does not operate well if draw imidiately one after the other
-	// I don't know why, but suspect it has to do with the ws2812 reset time
-	// not being handled correctly by the pru code.
-	// TODO: dig into the pru code and understand why
-	usleep(1e2 /* 100us */);
-	
-	// Send the frame to the PRU
-	ledscape_draw(leds, buffer_index);
-	
-	ChangeLedScapeBuffers();
-	fullFrameReady = false;
-}
-
-void SetAllSameColor(uint8_t r, uint8_t g, uint8_t b) {
-	for(int i=0; i<3; i++) {
-		for(int s = 0; s < LEDSCAPE_NUM_STRIPS; s++) {		
-			for(int i=0; i<pixelsPerStrand; i++)
-			{
-				ledscape_set_color(
-					frame,
-					COLOR_ORDER_BRG,
-					s,
-					i,
-					r,
-					g,
-					b
-				);
-			}	
-		}
-		SendColorsToStrips();	
-	}
-}
-
-void StartLedScape()
-{
-	printf("[main] Starting LEDscape...\n");
-
-	leds = ledscape_init_with_programs(
-		pixelsPerStrand,
-		"pru/bin/ws281x-come-million-box-pru0.bin",
-		"pru/bin/ws281x-come-million-box-pru1.bin"
-	);		
-	
-	ChangeLedScapeBuffers();
-
-	printf("[main] Done Starting LEDscape...\n");	
-}
-
-void ResetCounter(uint32_t newFrameId)
-{
-  	currentFrame = newFrameId;
-  	numOfReceivedSegments = 0;
-  	for(int i=0; i<MAX_SUPPORTED_SEGMENTS; i++) {
-    	receivedSegArr[i] = false;  
-	}
-}
-
-bool VerifyLedBurnPacket(const uint8_t packetBuf[], int packetSize)
-{
-  if(packetSize < LB_HEADER_SIZE)
-    return false;
-  if(memcmp(packetBuf, "LedBurn", 7) != 0)
-    return false;  
-  uint8_t protocolVersion = packetBuf[7];
-  if(protocolVersion != 0)
-    return false;
-  int payloadLength = (packetSize - LB_HEADER_SIZE);
-  if( (payloadLength % 3) != 0)
-    return false;
-
-  return true;
-}
-
-PacketHeaderData ParsePacketHeader(const uint8_t packetBuf[], int packetSize)
-{
-  PacketHeaderData phd;
-  
-  phd.frameId = (*((const uint32_t *) (packetBuf + 8) ));
-  phd.segInFrame = (*((const uint32_t *) (packetBuf + 12) ));
-
-  phd.currSegId = (*((const uint32_t *) (packetBuf + 16) ));
-  phd.stripId = (*((const uint16_t *) (packetBuf + 20) ));
-  phd.pixelId = (*((const uint16_t *) (packetBuf + 22) ));
-
-  phd.numOfPixels = (packetSize - LB_HEADER_SIZE) / 3;
-
-  return phd;
-}
-
-// return true if packet is ok.
-// return false if packet should be ignored
-bool BeforePaintLeds(const PacketHeaderData *phd)
-{
-  if(phd->segInFrame >= MAX_SUPPORTED_SEGMENTS || phd->currSegId >= phd->segInFrame)
-    return false;
-  
-  // this is the common case with no packet losses
-  if(phd->frameId == currentFrame)
-    return true;
-  
-  // if the current frame is old. don't use it!
-  // do the math with int64, to avoid overflows
-  // unless it's very old, in which case, assume the sender restarted and use it
-  int64_t diffFromCurrent = (int64_t)phd->frameId - (int64_t)currentFrame;
-  if(diffFromCurrent > -500 && diffFromCurrent < 0) // 500 is 10 seconds in 50HZ
-    return false;
-
-  // if we are here, then this frame is not what we expected, but it is not frame from udp re-order.
-  // so we change our reference point to it!
-  printf("info: new frame reference point detected. old frame id: %u. new frame id: %u. diff: %" PRId64 "\n", currentFrame, phd->frameId, diffFromCurrent);
-  ResetCounter(phd->frameId);
-  SendColorsToStrips(); // use the leds we already recived
-
-  if(diffFromCurrent < -500 || diffFromCurrent > 500) {
-  	SetAllSameColor(0, 0, 0);
-  }
-  return true;
-}
-
-void PaintLeds(const uint8_t packetBuf[], const PacketHeaderData *phd)
-{
-	// avoid overrun the allowed buffer
-	if(phd->stripId >= LEDSCAPE_NUM_STRIPS)
-		return;
-	if(phd->pixelId >= pixelsPerStrand)
-		return;
-	int numOfPixels = min(phd->numOfPixels, (uint16_t)(pixelsPerStrand - phd->pixelId) ); // pixelsPerStrand - phd.pixelId > 0
-
-	const uint8_t *bufStartPointer = (const uint8_t *)packetBuf + LB_HEADER_SIZE;
-
-	for(int i=0; i<numOfPixels; i++)
-	{
-		const uint8_t *pixelStartPointer = bufStartPointer + i * 3;
-		ledscape_set_color(
-			frame,
-			COLOR_ORDER_BRG,
-			phd->stripId,
-			phd->pixelId + i,
-			*(pixelStartPointer+0),
-			*(pixelStartPointer+1),
-			*(pixelStartPointer+2)
-		);
-	}
-}
-
-void AfterPaintLeds(const PacketHeaderData *phd)
-{
-  if(receivedSegArr[phd->currSegId])
-  {
-    // we already have this segment. this is a duplicate packet!
-    return;
-  }
-
-  receivedSegArr[phd->currSegId] = true;
-  numOfReceivedSegments++;
-
-  if(numOfReceivedSegments >= phd->segInFrame)
-  {
-  	ResetCounter(currentFrame + 1);
-  	fullFrameReady = true;
-  }
-}
-
-void MainLoop()
-{
-	printf("Initialize udp listen socket\n");
-	
-	const int sock = socket(AF_INET6, SOCK_DGRAM, 0);
-	if (sock < 0) {
-		die("[udp] socket failed: %s\n", strerror(errno));
-	}
-
-	// set the socket to non bloking.
-	int flags = fcntl(sock,F_GETFL);
-	flags |= O_NONBLOCK;
-	fcntl(sock, F_SETFL, flags);
-
-
-	struct sockaddr_in6 addr;
-	bzero(&addr, sizeof(addr));
-	addr.sin6_family = AF_INET6;
-	addr.sin6_addr = in6addr_any;
-	addr.sin6_port = htons(2000);
-
-	if (bind(sock, (const struct sockaddr*) &addr, sizeof(addr)) < 0)
-	{
-		die("[udp] bind port %d failed: %s\n", 2000, strerror(errno));
-	}
-
-	uint8_t buf[65536];
-	printf("Done initializing udp listen socket\n");	
-	
-	
-	printf("Starting main loop\n");
-	ChangeLedScapeBuffers(); // this will initialize it as well
-
-	for(;;) {
-		
-		const ssize_t rc = recv(sock, buf, sizeof(buf), 0);
-		if(rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
-			if(fullFrameReady == true && !is_ledscape_busy(leds)) {
-		    	SendColorsToStrips();
-		    }
-			continue;			
-		}
-		if (rc < 0) {
-			fprintf(stderr, "[udp] recv failed: %s\n", strerror(errno));
-			continue;
-		}
-		
-		if(!VerifyLedBurnPacket(buf, rc))
-		{
-			fprintf(stderr, "[udp] recv packet which is not of LedBurn protocol!\n");
-			continue;
-		}
-		
-		PacketHeaderData phd = ParsePacketHeader(buf, rc);
-		if(!BeforePaintLeds(&phd))
-		{
-		  fprintf(stderr, "[udp] BeforePaintLeds failed!\n");
-		  continue;
-		}
-		PaintLeds(buf, &phd);
-		AfterPaintLeds(&phd);
-	}
-
-	ledscape_close(leds);
-}
-
-void PlayInitSequence() {
-	SetAllSameColor(255, 0, 0);
-	usleep(1000 * 1000);
-	SetAllSameColor(0, 255, 0);
-	usleep(1000 * 1000);
-	SetAllSameColor(0, 0, 255);
-	usleep(1000 * 1000);
-	SetAllSameColor(0, 0, 0);
-}
-
-void SetNumberOfPixelsInStrand(int argc, char ** argv) {
-	if(argc > 1) {
-		char *endPtr;
-		errno = 0; /* To distinguish success/failure after call */
-		long numberOfPixels = strtol(argv[1], &endPtr, 10);\
-		
-		// check non integer values
-		if(endPtr == argv[1] || *endPtr != '\0') {
-			fprintf(stderr, "first parameter to the ledburn server should be number of pixels. received non integer value: '%s'\n", argv[1]);
-			exit(EXIT_FAILURE);
-		}
-		
-		// check out of range
-		if ((errno == ERANGE && (numberOfPixels == LONG_MAX || numberOfPixels == LONG_MIN)) || (errno != 0 && numberOfPixels == 0)) {
-			fprintf(stderr, "first parameter to the ledburn server should be number of pixels. received invalid value: %s\n", argv[1]);
-			exit(EXIT_FAILURE);
-		}
-		
-		// check if value is not reasonable
-
-		if(numberOfPixels > MAX_SUPPORTED_PIXELS_PER_STRAND || numberOfPixels <= 0) {
-			fprintf(stderr, "number of pixels from command line argument is not supported. value should be between [1, %d]. received: %ld\n", MAX_SUPPORTED_PIXELS_PER_STRAND, numberOfPixels);
-			exit(EXIT_FAILURE);			
-		}
-		
-		pixelsPerStrand = numberOfPixels;
-		printf("pixels per strand set from command line argument to = %d\n", pixelsPerStrand);
-	}
-	else {
-		printf("pixels per strand not set from command line argument. using default value %d\n", pixelsPerStrand);
-	}
-}
-
-int main(int argc, char ** argv)
-{
-	SetNumberOfPixelsInStrand(argc, argv);
-	StartLedScape();
-	PlayInitSequence();
-	MainLoop();
-}
+/** \file
+*  	LedBurn protocol server for beagle bone black.
+*	Receive udp packets with LedBurn protocol data, and sends it to ws281x led pixels
+*/
+#define _GNU_SOURCE // recvmmsg
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <string.h>
+#include <math.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <time.h>
+#include "ledscape.h"
+#include "dither.h"
+#include "calibration.h"
+#include "delta.h"
+#include "lz4_block.h"
+#include "palette.h"
+#include "clocksync.h"
+#include "fec.h"
+#include "universe.h"
+#include "artnet.h"
+#include "e131.h"
+#include "ddp.h"
+#include "sockbpf.h"
+#include "xsk.h"
+#include "hdrhist.h"
+#include "metrics.h"
+#include "profile.h"
+
+#ifndef UDP_GRO
+#define UDP_GRO 104 // linux 5.0, newer than the headers of older images
+#endif
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+
+#define MAX_SUPPORTED_PIXELS_PER_STRAND 1500
+#define DEFAULT_MAX_PIXELS 600
+#define LB_HEADER_SIZE (8+8+8)
+// version 1 adds encoding, flags, numOfPixels and refFrameId after the version 0 header
+#define LB_V1_HEADER_SIZE (LB_HEADER_SIZE+8)
+
+// the byte after the "LedBurn" magic holds the protocol version in the low nibble,
+// and the payload type (how pixels are encoded) in the high nibble
+#define LB_PROTOCOL_VERSION(b) ((b) & 0x0F)
+#define LB_PAYLOAD_TYPE(b) ((b) >> 4)
+
+typedef enum
+{
+  LB_PAYLOAD_RGB = 0,  // 3 bytes per pixel
+  LB_PAYLOAD_RGBW = 1, // 4 bytes per pixel, for sk6812 strips
+  LB_PAYLOAD_RGB16 = 2, // 6 bytes per pixel, 16 bit little endian channels
+  LB_PAYLOAD_RGB12 = 3, // 9 bytes per 2 pixels, 12 bit channels packed in pairs
+  LB_PAYLOAD_PALETTE8 = 4, // palette, then 1 index byte per pixel. version 1 only
+  LB_PAYLOAD_PALETTE4 = 5, // palette, then 1 index byte per 2 pixels. version 1 only
+  LB_NUM_OF_PAYLOAD_TYPES
+} LedBurnPayloadType;
+
+typedef enum
+{
+  LB_ENCODING_RAW = 0, // payload is the pixels, as in version 0
+  LB_ENCODING_XOR_RLE = 1, // payload is the run length encoded XOR with the same pixels of refFrameId, see delta.h
+  LB_NUM_OF_ENCODINGS
+} LedBurnEncoding;
+
+// version 1 flags
+#define LB_FLAG_LZ4 0x01 // payload is an LZ4 block, which decompresses to the encoded payload
+#define LB_FLAG_PIXEL_MAJOR 0x02 // payload is frame rows, see PaintLedsPixelMajor
+#define LB_FLAG_PRESENTATION_TIME 0x04 // the header is followed by the frame presentation time
+#define LB_FLAG_PARITY 0x08 // parity of segments currSegId .. currSegId + numOfPixels - 1, see fec.h
+#define LB_FLAG_SYNC 0x10 // no payload. commit frameId now, see HandleSync
+#define LB_KNOWN_FLAGS (LB_FLAG_LZ4 | LB_FLAG_PIXEL_MAJOR | LB_FLAG_PRESENTATION_TIME | LB_FLAG_PARITY | LB_FLAG_SYNC)
+#define LB_PRESENTATION_TIME_SIZE 8 // microseconds, on the clock master's CLOCK_REALTIME
+
+// payloads are made of groups of whole bytes, which may hold more than one pixel
+typedef struct LedBurnPixelGroup
+{
+  int bytes;
+  int pixels;
+} LedBurnPixelGroup;
+
+static const LedBurnPixelGroup lbPixelGroup[LB_NUM_OF_PAYLOAD_TYPES] = {
+  [LB_PAYLOAD_RGB] = {3, 1},
+  [LB_PAYLOAD_RGBW] = {4, 1},
+  [LB_PAYLOAD_RGB16] = {6, 1},
+  [LB_PAYLOAD_RGB12] = {9, 2},
+  // the index bytes. the palette before them is 1 byte with the number of entries (0 for 256),
+  // then 3 bytes (RGB) per entry
+  [LB_PAYLOAD_PALETTE8] = {1, 1},
+  [LB_PAYLOAD_PALETTE4] = {1, 2}
+};
+
+static inline bool LbHasPalette(uint8_t payloadType)
+{
+  return payloadType == LB_PAYLOAD_PALETTE8 || payloadType == LB_PAYLOAD_PALETTE4;
+}
+
+// bytes taken by numOfPixels pixels of a payload type. a partial group takes a whole group
+static inline int LbPayloadBytes(uint8_t payloadType, int numOfPixels)
+{
+  const LedBurnPixelGroup *group = &lbPixelGroup[payloadType];
+  return (numOfPixels + group->pixels - 1) / group->pixels * group->bytes;
+}
+
+int pixelsPerStrand = DEFAULT_MAX_PIXELS;
+
+// number of strips in a frame row. set from the command line, and rounded up by ledscape
+unsigned numStrips = LEDSCAPE_NUM_STRIPS;
+
+// the PRU program template used to clock out the frames, and how it lays out and times them
+typedef struct OutputMode
+{
+  const char *id; // template name, programs are pru/bin/<id>-<mapping>-pru<n>.bin
+  const char *description;
+  unsigned stripsPerPru; // clocked strips use two pins (data and clock) per strip
+  int maxPixels;
+  bool rgbw;
+  unsigned bitsPerPixel;
+  double bitTimeUs;
+  double frameOverheadUs; // preamble, start frame and latch time, for every frame
+  double endFrameBitsPerPixel; // apa102 ends with half a clock per pixel
+} OutputMode;
+
+static const OutputMode outputModes[] = {
+  { "ws281x", "WS2811 / WS2812 / WS2812b, 800KHz", LEDSCAPE_STRIPS_PER_PRU, MAX_SUPPORTED_PIXELS_PER_STRAND, false, 24, 1.25, 50, 0 },
+  { "sk6812", "SK6812 RGBW, 800KHz, 32 bits per pixel", LEDSCAPE_STRIPS_PER_PRU, MAX_SUPPORTED_PIXELS_PER_STRAND, true, 32, 1.25, 80, 0 },
+  { "apa102", "APA102 / SK9822, clocked at about 1.6MHz", LEDSCAPE_STRIPS_PER_PRU / 2, MAX_SUPPORTED_PIXELS_PER_STRAND, false, 32, 0.625, 32 * 0.625, 0.5 },
+  { "ws2801", "WS2801, clocked at about 1.6MHz", LEDSCAPE_STRIPS_PER_PRU / 2, MAX_SUPPORTED_PIXELS_PER_STRAND, false, 24, 0.625, 1000, 0 },
+  { "dmx", "DMX512, 250Kbaud, one universe per strip", LEDSCAPE_STRIPS_PER_PRU, 170, false, 33, 4, 365 + 2505, 0 }
+};
+#define NUM_OF_OUTPUT_MODES (sizeof(outputModes) / sizeof(outputModes[0]))
+
+const OutputMode *outputMode = &outputModes[0];
+const char *outputMapping = "come-million-box";
+
+// drive sk6812 RGBW strips (32 bits per pixel) instead of ws281x
+bool rgbwOutput = false;
+
+// high bit depth payloads are cached here and dithered into the frame on every send.
+// allocated when the first such payload arrives
+dither_t *dither = NULL;
+double highDepthGamma = 1.0;
+bool highDepthStrip[LEDSCAPE_NUM_STRIPS] = {false};
+
+// when calibrating, the calibrated frame is written to the PRU buffer when the frame is committed
+const char *calibrationFile = NULL;
+calibration_t *calibration = NULL;
+
+// payloads of the last displayed frame, for delta encoded segments.
+// allocated when the first version 1 packet arrives
+delta_t *delta = NULL;
+
+#define FEC_ARENA_SIZE (1024 * 1024)
+uint8_t fecRecovered[65536];
+
+uint64_t sentFrames = 0;
+#define STATS_INTERVAL 500 // frames
+
+// counters reported to the sender. the packet handling only increments them
+typedef struct LedBurnCounters
+{
+  uint32_t partialFrames; // sent with segments missing
+  uint32_t segments;
+  uint32_t duplicateSegments;
+  uint32_t lateSegments; // of frames older than the current one
+  uint32_t invalidPackets;
+  uint32_t decodeFailures;
+  uint32_t rxQueueDrops; // datagrams dropped by the kernel because the socket buffer was full (SO_RXQ_OVFL)
+} LedBurnCounters;
+LedBurnCounters counters;
+
+// the telemetry datagram, sent to the last sender every telemetryIntervalMs. little endian
+#define LB_TELEMETRY_VERSION 1
+typedef struct LedBurnTelemetry
+{
+  char magic[7]; // "LBTelem"
+  uint8_t version;
+  uint32_t seq;
+  uint32_t lastFrameId;
+  uint32_t framesDisplayed;
+  LedBurnCounters counters;
+  uint32_t pruFrameUs; // the PRU took this long to send the last frame
+  uint32_t pruWaitUs; // longest wait for the PRU before a frame could be drawn, since the last report
+} __attribute__((__packed__)) LedBurnTelemetry;
+
+// drops malformed LedBurn datagrams before they are copied to us, see AttachLedBurnFilter
+sockbpf_prog_t ledBurnFilter;
+bool ledBurnFilterAttached = false;
+uint32_t FilteredPackets();
+void PrintFilterStats();
+
+int telemetryIntervalMs = 0; // 0 disables telemetry
+struct sockaddr_in6 packetFrom; // source of the last datagram
+struct sockaddr_in6 telemetryPeer; // source of the last LedBurn packet
+bool telemetryHasPeer = false;
+uint64_t lastTelemetryUs = 0;
+uint32_t telemetrySeq = 0;
+uint64_t drawStartUs = 0; // 0 once the PRU is done with the frame
+uint32_t pruFrameUs = 0;
+uint32_t pruWaitUs = 0;
+
+// LZ4 payloads are decompressed here. pixel major segments may take a whole datagram
+uint8_t lz4Scratch[65536];
+
+// multicast group to join, and the interface to join it on (the default route's if NULL)
+const char *multicastGroup = NULL;
+const char *multicastInterface = NULL;
+
+// global strip id of our first strip. segments for strips outside [stripOffset, stripOffset + numStrips)
+// belong to other controllers on the same stream
+unsigned stripOffset = 0;
+int controllerId = -1;
+
+// DMX receivers, on their own sockets. each is off unless its option gives the first universe
+const char *universeMapFile = NULL;
+unsigned universePixels = UNIVERSE_MAX_PIXELS;
+int artnetUniverse = -1;
+universe_map_t *artnetMap = NULL;
+int e131Universe = -1;
+universe_map_t *e131Map = NULL;
+e131_merge_t *e131Merge = NULL;
+e131_merge_policy_t e131MergePolicy = E131_MERGE_HTP;
+int e131Sock = -1;
+uint16_t e131SyncUniverse = 0; // of the last data packet that asked to wait for syncs
+const struct sockaddr_in6 e131Session = { .sin6_family = AF_INET6, .sin6_port = 0 }; // all sources are merged into one
+#define RECV_BATCH 32 // datagrams per recvmmsg
+#define RECV_DATAGRAM_SIZE 9000 // DDP senders may use jumbo frames
+
+// Open Pixel Control, on TCP and UDP. a set pixel colors message for channel 0 holds the pixels of
+// the strips one after the other, and is a frame
+#define OPC_DEFAULT_PORT 7890
+#define OPC_HEADER_SIZE 4
+#define OPC_CHANNEL_ALL 0
+#define OPC_SET_PIXELS 0
+#define MAX_OPC_CLIENTS 4
+#define OPC_READ_SIZE 16384 // a message is read this much at a time, and painted as it arrives
+int opcPort = 0;
+
+bool ddpEnabled = false;
+#define DDP_FRAME_TIMEOUT_US 20000 // a sender that never pushes paused this long: its frame is complete
+
+// with UDP_GRO the kernel hands a run of same size LedBurn datagrams from a sender over in one read
+bool groEnabled = false;
+uint64_t groReceives = 0; // reads that held more than one datagram
+uint64_t groSegments = 0; // datagrams in them
+
+// AF_XDP ingest: LedBurn datagrams to the interface's IPv4 addresses skip the stack. see xsk.h
+const char *xdpInterface = NULL; // <interface>[:queue]
+xsk_mode_t xdpMode = XSK_MODE_AUTO;
+xsk_t *xdpSocket = NULL;
+
+// receive timing. the kernel timestamps LedBurn datagrams as they arrive (SO_TIMESTAMPNS); segments of the
+// other protocols and of the AF_XDP path get the time they are handled. CLOCK_REALTIME microseconds
+uint64_t packetRxUs = 0; // of the datagram being handled, 0 if the kernel gave none
+uint64_t readyFirstSegmentUs = 0, readyLastSegmentUs = 0; // of the frame being painted, once a session completed it
+uint64_t pendingFirstSegmentUs = 0, pendingLastSegmentUs = 0; // of the frame waiting to be sent
+uint64_t lastFrameFirstUs = 0; // of the last frame sent
+int64_t lastFrameIntervalUs = -1;
+hdrhist_t segmentSpreadHist; // first to last segment of a frame: the network and the sender's pacing
+hdrhist_t assemblyHist; // first segment to the PRU: adds the wait for other senders, presentation times and the PRU
+hdrhist_t jitterHist; // change in the interval between the first segments of consecutive frames: the sender's timing
+
+// metrics of the endpoint (--metrics) that aren't telemetry counters, which are registered as they are. see InitMetrics
+const char *metricsEndpoint = NULL;
+metric_t *packetsMetric, *bytesMetric, *referenceResetsMetric, *framesMetric, *pruBusyMetric, *pruWaitMetric;
+
+// stages of the packet loop a PROFILE=1 build times, see profile.h
+enum { STAGE_RECV, STAGE_VERIFY, STAGE_PAINT, STAGE_AFTER_PAINT, STAGE_DITHER, STAGE_CALIBRATION, STAGE_PRU_WAIT, STAGE_SLEEP, NUM_STAGES };
+const char * const stageNames[NUM_STAGES] = { "recv", "verify", "paint", "after_paint", "dither", "calibration", "pru_wait", "sleep" };
+
+typedef struct OpcClient
+{
+  int fd; // 0 if unused
+  struct sockaddr_in6 addr;
+  uint8_t header[OPC_HEADER_SIZE];
+  unsigned headerBytes;
+  unsigned length; // of the message's data
+  unsigned offset; // data bytes painted, or skipped, so far
+  uint8_t data[OPC_READ_SIZE];
+  unsigned dataBytes; // read but not painted yet. between reads, at most a partial pixel
+} OpcClient;
+OpcClient opcClients[MAX_OPC_CLIENTS];
+
+// presentation times are only honored when the clock is synced with a master
+const char *clockMaster = NULL;
+struct sockaddr_in6 clockMasterAddr;
+clocksync_t clockSync;
+int serveClockPort = 0; // run as a stand-in clock master on this port
+#define CLOCK_SYNC_INTERVAL_US 1000000
+#define CLOCK_STATS_INTERVAL 10 // replies
+#define PRESENTATION_MAX_WAIT_US 1000000 // later than this, the clocks are wrong. don't wait
+#define PRESENTATION_LATE_US 1000
+
+// presentation time of the frame being painted, once a session completed it, and of the frame waiting
+// to be sent. 0 if none
+uint64_t readyPresentationUs = 0;
+uint64_t pendingPresentationUs = 0;
+uint64_t presentedFrames = 0;
+uint64_t lateFrames = 0;
+int64_t maxLatenessUs = 0;
+
+bool runBenchmark = false;
+bool listOutputModes = false;
+
+// we support up to 12288 segments, or 64 segments per strip for 4 controllers with all strips used, which is
+// 10 pixels per packet. segments of other controllers on a multicast stream count towards the frame too.
+// this is more than enough
+#define MAX_SUPPORTED_SEGMENTS (LEDSCAPE_NUM_STRIPS * 64 * 4)
+
+// every sender (address and port) assembles its own frames, usually for its own strips
+typedef struct LedBurnSession
+{
+  bool inUse;
+  struct sockaddr_in6 addr;
+  uint64_t lastSeenFrame; // sentFrames when the session last received a packet
+
+  // segments of the current frame, by segment id. a segment was received when its entry matches
+  // segGeneration, which moves on with every frame, so nothing is cleared between frames
+  uint32_t receivedSegGen[MAX_SUPPORTED_SEGMENTS];
+  uint32_t segGeneration;
+  uint32_t currentFrame;
+  uint32_t numOfReceivedSegments;
+  uint32_t currentSegInFrame;
+  uint64_t framePresentationUs; // of the frame being received, 0 if none
+  uint64_t firstSegmentUs, lastSegmentUs; // receive times of the frame being received, 0 if none
+
+  // the session's last frame is complete, and waits for the combined frame to be sent
+  bool frameReady;
+  unsigned heldDatagrams; // of its next frames, see HoldDatagram
+
+  // once a sync packet arrives, frames are committed by sync packets, and not when all their segments arrived
+  bool syncMode;
+
+  // datagrams of the current frame, to rebuild lost segments from parity segments.
+  // allocated when the first parity segment arrives
+  fec_t *fec;
+
+  // the frame of this sender that delta segments refer to
+  delta_ref_t deltaRef;
+
+  // a DDP sender's datagrams are the segments of its frames, of the length of its longest one
+  bool ddp;
+  unsigned ddpSegmentBytes;
+} LedBurnSession;
+
+#define MAX_SESSIONS 4
+#define SESSION_IDLE_FRAMES 100 // a session that sent nothing for this many frames is not waited for
+LedBurnSession sessions[MAX_SESSIONS];
+LedBurnSession *session = NULL; // of the packet being handled
+
+// the datagram being handled, and the receiver to handle it again with. no handler for OPC streams
+typedef void (*DatagramHandler)(const uint8_t buf[], int len, const struct sockaddr_in6 *from);
+typedef struct HandledDatagram
+{
+  DatagramHandler handler;
+  const uint8_t *buf;
+  int len;
+  const struct sockaddr_in6 *from;
+} HandledDatagram;
+HandledDatagram handled;
+
+// datagrams of the senders' next frames, held while their last frames wait for the other senders, the PRU
+// buffer or their presentation time, and handled once those frames are committed
+#define HOLD_ARENA_SIZE (256 * 1024)
+#define MAX_HELD_DATAGRAMS 2048
+typedef struct HeldDatagram
+{
+  DatagramHandler handler; // NULL once handled
+  struct sockaddr_in6 from;
+  LedBurnSession *session;
+  uint64_t rxUs;
+  uint32_t offset; // in the arena
+  uint16_t len;
+} HeldDatagram;
+uint8_t holdArena[HOLD_ARENA_SIZE];
+size_t holdArenaUsed = 0;
+HeldDatagram heldDatagrams[MAX_HELD_DATAGRAMS];
+unsigned numHeldDatagrams = 0;
+bool replayingDatagrams = false;
+
+// when the combined frame is sent: once all the active sessions completed a frame, or once any did
+typedef enum
+{
+  MERGE_ALL,
+  MERGE_ANY
+} MergePolicy;
+MergePolicy mergePolicy = MERGE_ALL;
+
+// framerate protection
+bool fullFrameReady = false;
+
+// LedScape things. packets are painted into a regular (cached) buffer. once the frame is complete, it is
+// committed: copied, or calibrated, to the PRU buffer the PRU isn't sending, where it is pending until the
+// PRU is done with the previous frame and its presentation time comes. meanwhile the next frame is painted
+ledscape_t *leds = NULL;
+uint8_t buffer_index = 0; // the PRU buffer of the pending frame, or of the next one
+ledscape_frame_t *frame = NULL; // being painted
+bool pendingFrameReady = false;
+
+typedef struct PacketHeaderData
+{
+  uint32_t frameId;
+  uint32_t segInFrame;
+  uint32_t currSegId;
+  uint16_t stripId;
+  uint16_t pixelId;
+  uint8_t protocolVersion;
+  uint8_t payloadType;
+  uint8_t encoding;
+  uint8_t flags;
+  uint32_t refFrameId;
+  uint64_t presentationUs; // master clock, 0 if none
+  uint16_t numOfPixels; // in version 0, this is not actually header data, but it's nice to have it here
+  const uint8_t *payload; // pixels, once decoded
+  int payloadLength;
+} PacketHeaderData;
+
+void ChangeLedScapeBuffers()
+{
+	buffer_index = (buffer_index+1)%2;
+}
+
+void DitherHighDepthStrips()
+{
+	if(dither == NULL)
+		return;
+	for(unsigned s = 0; s < numStrips; s++) {
+		if(highDepthStrip[s])
+			dither_strip_to_frame(dither, frame, s, rgbwOutput);
+	}
+}
+
+// once the PRU is done with a frame, note how long it took. only called when the PRU is idle
+void TrackPruFrameTime()
+{
+	if(drawStartUs == 0)
+		return;
+	pruFrameUs = clocksync_now_us(CLOCK_MONOTONIC) - drawStartUs;
+	metrics_add(pruBusyMetric, pruFrameUs);
+	drawStartUs = 0;
+}
+
+// the receive timing of the frame going to the PRU. frames of the init sequence have none
+void TrackFrameTiming()
+{
+	if(pendingFirstSegmentUs == 0)
+		return;
+	const uint64_t flushUs = clocksync_now_us(CLOCK_REALTIME);
+	hdrhist_record(&segmentSpreadHist, pendingLastSegmentUs - pendingFirstSegmentUs);
+	hdrhist_record(&assemblyHist, flushUs > pendingFirstSegmentUs ? flushUs - pendingFirstSegmentUs : 0);
+	if(lastFrameFirstUs) {
+		const int64_t intervalUs = pendingFirstSegmentUs - lastFrameFirstUs;
+		if(lastFrameIntervalUs >= 0)
+			hdrhist_record(&jitterHist, llabs(intervalUs - lastFrameIntervalUs));
+		lastFrameIntervalUs = intervalUs;
+	}
+	lastFrameFirstUs = pendingFirstSegmentUs;
+	pendingFirstSegmentUs = pendingLastSegmentUs = 0;
+}
+
+// the histograms cover the frames since the last print
+void PrintFrameTimingStats()
+{
+	hdrhist_print(&segmentSpreadHist, "info: segment spread");
+	hdrhist_print(&assemblyHist, "info: frame assembly");
+	hdrhist_print(&jitterHist, "info: frame jitter");
+	hdrhist_reset(&segmentSpreadHist);
+	hdrhist_reset(&assemblyHist);
+	hdrhist_reset(&jitterHist);
+}
+
+// the displayed frame becomes the delta reference. each sender's strips hold its frame if it completed
+// one, a mix of its frames if it sent part of the next, or its reference still if it sent nothing since
+void CommitDeltaReferences()
+{
+	delta_commit(delta);
+	for(int i=0; i<MAX_SESSIONS; i++) {
+		if(sessions[i].inUse)
+			delta_ref_commit(&sessions[i].deltaRef, sessions[i].frameReady);
+	}
+}
+
+// what the packet loop counted since the last summary, instead of logging as it happens
+void PrintPacketSummary()
+{
+	static LedBurnCounters last;
+	static uint64_t lastPackets, lastResets;
+	const uint64_t packets = metrics_get(packetsMetric);
+	const uint64_t resets = metrics_get(referenceResetsMetric);
+	printf("info: %" PRIu64 " packets, %u invalid, %u duplicate, %u late, %u decode failures, %" PRIu64 " frame reference resets, %u partial frames\n",
+		packets - lastPackets, counters.invalidPackets - last.invalidPackets, counters.duplicateSegments - last.duplicateSegments,
+		counters.lateSegments - last.lateSegments, counters.decodeFailures - last.decodeFailures, resets - lastResets,
+		counters.partialFrames - last.partialFrames);
+	last = counters;
+	lastPackets = packets;
+	lastResets = resets;
+}
+
+// the painted frame becomes the pending frame. only called when there is none, so the PRU buffer it goes to
+// is free: the PRU only reads the other one
+void CommitFrame()
+{
+	PROFILE_START(ditherStart);
+	DitherHighDepthStrips();
+	PROFILE_END(STAGE_DITHER, ditherStart);
+
+	if(delta)
+		CommitDeltaReferences();
+	if(!fullFrameReady)
+		counters.partialFrames++;
+
+	if(calibration) {
+		PROFILE_START(calibrationStart);
+		calibration_apply(calibration, ledscape_frame(leds, buffer_index), frame);
+		PROFILE_END(STAGE_CALIBRATION, calibrationStart);
+	} else {
+		memcpy(ledscape_frame(leds, buffer_index), frame, ledscape_frame_size(numStrips, pixelsPerStrand));
+	}
+
+	pendingFrameReady = true;
+	pendingPresentationUs = readyPresentationUs;
+	pendingFirstSegmentUs = readyFirstSegmentUs;
+	pendingLastSegmentUs = readyLastSegmentUs;
+	readyPresentationUs = readyFirstSegmentUs = readyLastSegmentUs = 0;
+	fullFrameReady = false;
+	for(int i=0; i<MAX_SESSIONS; i++)
+		sessions[i].frameReady = false;
+}
+
+// send the pending frame to the PRU, once it is done with the previous one
+void DrawPendingFrame()
+{
+	metrics_add(framesMetric, 1);
+	if(++sentFrames % STATS_INTERVAL == 0) {
+		PrintPacketSummary();
+		if(delta)
+			delta_print_stats(delta);
+		for(int i=0; i<MAX_SESSIONS; i++) {
+			if(sessions[i].inUse && sessions[i].fec)
+				fec_print_stats(sessions[i].fec);
+		}
+		if(e131Merge)
+			e131_print_stats(e131Merge);
+		if(ledBurnFilterAttached)
+			PrintFilterStats();
+		if(groReceives)
+			printf("info: gro: %" PRIu64 " coalesced reads, %.1f datagrams per read\n", groReceives, (double) groSegments / groReceives);
+		if(xdpSocket)
+			xsk_print_stats(xdpSocket);
+		if(segmentSpreadHist.total)
+			PrintFrameTimingStats();
+	}
+
+	// Wait for previous send to complete if still in progress
+	const uint64_t waitStartUs = clocksync_now_us(CLOCK_MONOTONIC);
+	PROFILE_START(pruWaitStart);
+	ledscape_wait(leds);
+	PROFILE_END(STAGE_PRU_WAIT, pruWaitStart);
+	const uint64_t waitUs = clocksync_now_us(CLOCK_MONOTONIC) - waitStartUs;
+	if(waitUs > pruWaitUs)
+		pruWaitUs = waitUs;
+	metrics_add(pruWaitMetric, waitUs);
+	TrackPruFrameTime();
+	
+	// the following line is critical for the leds to have proper display.
+	// if it is absent, the leds does not operate well if draw imidiately one after the other
+	// I don't know why, but suspect it has to do with the ws2812 reset time
+	// not being handled correctly by the pru code.
+	// TODO: dig into the pru code and understand why
+	PROFILE_START(sleepStart);
+	usleep(1e2 /* 100us */);
+	PROFILE_END(STAGE_SLEEP, sleepStart);
+	
+	// Send the frame to the PRU
+	TrackFrameTiming();
+	ledscape_draw(leds, buffer_index);
+	drawStartUs = clocksync_now_us(CLOCK_MONOTONIC);
+	
+	ChangeLedScapeBuffers();
+	pendingFrameReady = false;
+	pendingPresentationUs = 0;
+}
+
+bool IsPresentationDue();
+
+// commit the complete frame once the PRU buffer is free, and send the pending frame once the PRU is idle
+// and its presentation time came
+void FlushFrames()
+{
+	if(fullFrameReady && !pendingFrameReady)
+		CommitFrame();
+	if(!pendingFrameReady || is_ledscape_busy(leds) || !IsPresentationDue())
+		return;
+	DrawPendingFrame();
+	if(fullFrameReady)
+		CommitFrame();
+}
+
+// send what was painted now, complete or not, and whatever the presentation times
+void SendColorsToStrips()
+{
+	if(pendingFrameReady)
+		DrawPendingFrame();
+	CommitFrame();
+	DrawPendingFrame();
+}
+
+// a session starts its next frame while its last one waits, and there is no room to hold it. commit the
+// frame if it can wait in the PRU buffer, without changing. if the PRU buffer holds a frame still, send it
+void CommitOrSendFrame()
+{
+	if(pendingFrameReady)
+		SendColorsToStrips();
+	else
+		CommitFrame();
+}
+
+// the session's datagrams are held while its last frame waits, and until the held ones are handled,
+// so they are handled in the order they arrived
+bool HoldsDatagrams()
+{
+	return session->frameReady || (session->heldDatagrams > 0 && !replayingDatagrams);
+}
+
+// keep the datagram being handled until the session's last frame is committed. if there is no room,
+// commit or send the last frame now, and return false to handle the datagram right away
+bool HoldDatagram()
+{
+	if(handled.handler != NULL && numHeldDatagrams < MAX_HELD_DATAGRAMS && holdArenaUsed + handled.len <= HOLD_ARENA_SIZE) {
+		HeldDatagram *held = &heldDatagrams[numHeldDatagrams++];
+		held->handler = handled.handler;
+		held->from = *handled.from;
+		held->session = session;
+		held->rxUs = packetRxUs ? packetRxUs : clocksync_now_us(CLOCK_REALTIME);
+		held->offset = holdArenaUsed;
+		held->len = handled.len;
+		memcpy(holdArena + holdArenaUsed, handled.buf, handled.len);
+		holdArenaUsed += handled.len;
+		session->heldDatagrams++;
+		return true;
+	}
+
+	warn_once("senders are more than %d KB ahead of the frames waiting to be sent, sending them early\n", HOLD_ARENA_SIZE / 1024);
+	if(session->frameReady)
+		CommitOrSendFrame();
+	return false;
+}
+
+// handle the held datagrams of the sessions whose last frames were committed, in the order they arrived.
+// the ones of sessions still waiting are kept, and so are the ones held again
+void ReplayHeldDatagrams()
+{
+	const unsigned count = numHeldDatagrams;
+	if(count == 0)
+		return;
+
+	replayingDatagrams = true;
+	for(unsigned i=0; i<count; i++) {
+		HeldDatagram *held = &heldDatagrams[i];
+		if(held->session->frameReady)
+			continue;
+		if(held->session->heldDatagrams > 0)
+			held->session->heldDatagrams--;
+		packetRxUs = held->rxUs;
+		held->handler(holdArena + held->offset, held->len, &held->from);
+		held->handler = NULL;
+	}
+	replayingDatagrams = false;
+	packetRxUs = 0;
+
+	unsigned kept = 0;
+	holdArenaUsed = 0;
+	for(unsigned i=0; i<numHeldDatagrams; i++) {
+		HeldDatagram held = heldDatagrams[i];
+		if(held.handler == NULL)
+			continue;
+		memmove(holdArena + holdArenaUsed, holdArena + held.offset, held.len);
+		held.offset = holdArenaUsed;
+		holdArenaUsed += held.len;
+		heldDatagrams[kept++] = held;
+	}
+	numHeldDatagrams = kept;
+}
+
+void SetAllSameColor(uint8_t r, uint8_t g, uint8_t b) {
+	// the solid color replaces whatever high depth content we had
+	for(int s = 0; s < LEDSCAPE_NUM_STRIPS; s++) {
+		highDepthStrip[s] = false;
+	}
+	if(dither != NULL) {
+		dither_clear(dither);
+	}
+	for(int i=0; i<3; i++) {
+		for(unsigned s = 0; s < numStrips; s++) {		
+			for(int i=0; i<pixelsPerStrand; i++)
+			{
+				if(rgbwOutput) {
+					ledscape_set_color_rgb_to_rgbw(frame, numStrips, s, i, r, g, b);
+					continue;
+				}
+				ledscape_set_color(
+					frame,
+					numStrips,
+					COLOR_ORDER_BRG,
+					s,
+					i,
+					r,
+					g,
+					b
+				);
+			}	
+		}
+		SendColorsToStrips();	
+	}
+}
+
+// the time it takes the PRU to clock out one frame, plus the pause SendColorsToStrips takes before each frame
+double OutputModeFrameTimeUs(const OutputMode *mode, int numOfPixels)
+{
+	const double pixelTimeUs = (mode->bitsPerPixel + mode->endFrameBitsPerPixel) * mode->bitTimeUs;
+	return mode->frameOverheadUs + numOfPixels * pixelTimeUs + 100;
+}
+
+void PrintOutputModes(int numOfPixels)
+{
+	printf("output modes, estimated frame rate for %d pixels per strand:\n", numOfPixels);
+	for(unsigned m=0; m<NUM_OF_OUTPUT_MODES; m++) {
+		const OutputMode *mode = &outputModes[m];
+		const int pixels = min(numOfPixels, mode->maxPixels);
+		const double frameTimeUs = OutputModeFrameTimeUs(mode, pixels);
+		printf("  %-8s %2u strips %s%8.1f us/frame %7.1f fps  %s\n",
+			mode->id,
+			2 * mode->stripsPerPru,
+			pixels < numOfPixels ? "(max pixels) " : "             ",
+			frameTimeUs,
+			1e6 / frameTimeUs,
+			mode->description);
+	}
+}
+
+const OutputMode *FindOutputMode(const char *id)
+{
+	for(unsigned m=0; m<NUM_OF_OUTPUT_MODES; m++) {
+		if(strcmp(outputModes[m].id, id) == 0)
+			return &outputModes[m];
+	}
+	return NULL;
+}
+
+// check the strip and pixel counts fit the mode, now that all the options are known
+void ValidateOutputMode()
+{
+	if(numStrips > 2 * outputMode->stripsPerPru) {
+		fprintf(stderr, "output mode %s supports up to %u strips. requested: %u\n", outputMode->id, 2 * outputMode->stripsPerPru, numStrips);
+		exit(EXIT_FAILURE);
+	}
+	if(pixelsPerStrand > outputMode->maxPixels) {
+		fprintf(stderr, "output mode %s supports up to %d pixels per strand. requested: %d\n", outputMode->id, outputMode->maxPixels, pixelsPerStrand);
+		exit(EXIT_FAILURE);
+	}
+	rgbwOutput = outputMode->rgbw;
+
+	const double frameTimeUs = OutputModeFrameTimeUs(outputMode, pixelsPerStrand);
+	printf("output mode %s, mapping %s: %u strips x %d pixels, about %.1f us per frame (%.1f fps)\n",
+		outputMode->id, outputMapping, numStrips, pixelsPerStrand, frameTimeUs, 1e6 / frameTimeUs);
+}
+
+void StartLedScape()
+{
+	printf("[main] Starting LEDscape...\n");
+
+	// ledscape keeps the file names, so they must outlive this function
+	static char pru0Program[PATH_MAX];
+	static char pru1Program[PATH_MAX];
+	snprintf(pru0Program, sizeof(pru0Program), "pru/bin/%s-%s-pru0.bin", outputMode->id, outputMapping);
+	snprintf(pru1Program, sizeof(pru1Program), "pru/bin/%s-%s-pru1.bin", outputMode->id, outputMapping);
+	if(access(pru0Program, R_OK) != 0 || access(pru1Program, R_OK) != 0)
+		die("PRU programs %s and %s not found. is the mapping in pru/mappings and were the templates built?\n", pru0Program, pru1Program);
+
+	leds = ledscape_init_with_strips(
+		numStrips,
+		outputMode->stripsPerPru,
+		pixelsPerStrand,
+		pru0Program,
+		pru1Program
+	);
+	frame = calloc(1, ledscape_frame_size(numStrips, pixelsPerStrand));
+	if(frame == NULL)
+		die("unable to allocate the frame\n");
+
+	printf("[main] Done Starting LEDscape...\n");	
+}
+
+void LoadCalibration()
+{
+	if(calibrationFile == NULL)
+		return;
+
+	calibration = calibration_load(calibrationFile, numStrips, pixelsPerStrand, rgbwOutput);
+	printf("[main] Loaded calibration from %s\n", calibrationFile);
+}
+
+void ResetCounter(uint32_t newFrameId)
+{
+  	if(session->fec != NULL)
+  		fec_end_frame(session->fec);
+  	session->currentFrame = newFrameId;
+  	session->numOfReceivedSegments = 0;
+  	session->framePresentationUs = 0;
+  	session->firstSegmentUs = session->lastSegmentUs = 0;
+  	session->segGeneration++;
+}
+
+bool SegmentReceived(uint32_t segId)
+{
+	return session->receivedSegGen[segId] == session->segGeneration;
+}
+
+// find the session of a sender, or start one, replacing the one that was idle the longest
+LedBurnSession *FindSession(const struct sockaddr_in6 *from)
+{
+	LedBurnSession *found = NULL;
+	for(int i=0; i<MAX_SESSIONS && found == NULL; i++) {
+		if(sessions[i].inUse
+		&& sessions[i].addr.sin6_port == from->sin6_port
+		&& memcmp(&sessions[i].addr.sin6_addr, &from->sin6_addr, sizeof(from->sin6_addr)) == 0)
+			found = &sessions[i];
+	}
+
+	if(found == NULL) {
+		found = &sessions[0];
+		for(int i=1; i<MAX_SESSIONS && found->inUse; i++) {
+			if(!sessions[i].inUse || sessions[i].lastSeenFrame < found->lastSeenFrame)
+				found = &sessions[i];
+		}
+
+		char name[INET6_ADDRSTRLEN];
+		inet_ntop(AF_INET6, &from->sin6_addr, name, sizeof(name));
+		printf("info: new sender [%s]:%u\n", name, ntohs(from->sin6_port));
+
+		fec_t *fec = found->fec;
+		if(fec != NULL)
+			fec_end_frame(fec);
+		memset(found, 0, sizeof(*found));
+		found->fec = fec; // keep the arena, if the previous sender used one
+		found->inUse = true;
+		found->addr = *from;
+		found->segGeneration = 1; // the entries are 0
+
+	}
+
+	found->lastSeenFrame = sentFrames;
+	return found;
+}
+
+// a sender that closed its connection is not waited for
+void ForgetSession(const struct sockaddr_in6 *from)
+{
+	for(int i=0; i<MAX_SESSIONS; i++) {
+		if(sessions[i].inUse
+		&& sessions[i].addr.sin6_port == from->sin6_port
+		&& memcmp(&sessions[i].addr.sin6_addr, &from->sin6_addr, sizeof(from->sin6_addr)) == 0)
+			sessions[i].inUse = false;
+	}
+}
+
+// the session completed a frame. decide if the combined frame is ready, by the merge policy
+void CommitSessionFrame()
+{
+	session->frameReady = true;
+	if(session->framePresentationUs)
+		readyPresentationUs = session->framePresentationUs;
+	if(session->firstSegmentUs && (readyFirstSegmentUs == 0 || session->firstSegmentUs < readyFirstSegmentUs))
+		readyFirstSegmentUs = session->firstSegmentUs;
+	if(session->lastSegmentUs > readyLastSegmentUs)
+		readyLastSegmentUs = session->lastSegmentUs;
+	ResetCounter(session->currentFrame + 1);
+
+	if(mergePolicy == MERGE_ANY) {
+		fullFrameReady = true;
+		return;
+	}
+	for(int i=0; i<MAX_SESSIONS; i++) {
+		const LedBurnSession *other = &sessions[i];
+		if(other->inUse && !other->frameReady && sentFrames - other->lastSeenFrame <= SESSION_IDLE_FRAMES)
+			return;
+	}
+	fullFrameReady = true;
+}
+
+bool VerifyLedBurnPacket(const uint8_t packetBuf[], int packetSize)
+{
+  if(packetSize < LB_HEADER_SIZE)
+    return false;
+  if(memcmp(packetBuf, "LedBurn", 7) != 0)
+    return false;  
+  uint8_t protocolVersion = LB_PROTOCOL_VERSION(packetBuf[7]);
+  if(protocolVersion > 1)
+    return false;
+  uint8_t payloadType = LB_PAYLOAD_TYPE(packetBuf[7]);
+  if(payloadType >= LB_NUM_OF_PAYLOAD_TYPES)
+    return false;
+
+  if(protocolVersion == 0) {
+    if(LbHasPalette(payloadType))
+      return false;
+    int payloadLength = (packetSize - LB_HEADER_SIZE);
+    if( (payloadLength % lbPixelGroup[payloadType].bytes) != 0)
+      return false;
+    return true;
+  }
+
+  if(packetSize < LB_V1_HEADER_SIZE)
+    return false;
+  uint8_t encoding = packetBuf[24];
+  if(encoding >= LB_NUM_OF_ENCODINGS)
+    return false;
+  uint8_t flags = packetBuf[25];
+  if(flags & ~LB_KNOWN_FLAGS)
+    return false;
+  int headerSize = LB_V1_HEADER_SIZE + ((flags & LB_FLAG_PRESENTATION_TIME) ? LB_PRESENTATION_TIME_SIZE : 0);
+  if(packetSize < headerSize)
+    return false;
+  uint16_t numOfPixels = (*((const uint16_t *) (packetBuf + 26) ));
+  if(numOfPixels == 0 && !(flags & LB_FLAG_SYNC))
+    return false;
+  // payloads are cached by their byte offset in the strip, so they must start on a whole group
+  uint16_t pixelId = (*((const uint16_t *) (packetBuf + 22) ));
+  if(pixelId % lbPixelGroup[payloadType].pixels != 0)
+    return false;
+  // palettes are expanded to RGB in the reference frame, so they are never delta encoded
+  if(LbHasPalette(payloadType) && encoding != LB_ENCODING_RAW)
+    return false;
+  // parity segments cover whole datagrams, whatever they hold
+  if((flags & LB_FLAG_PARITY) && (encoding != LB_ENCODING_RAW || payloadType != LB_PAYLOAD_RGB
+    || (*((const uint32_t *) (packetBuf + 16) )) + numOfPixels > (*((const uint32_t *) (packetBuf + 12) ))))
+    return false;
+  // sync packets are just the header
+  if((flags & LB_FLAG_SYNC) && packetSize != headerSize)
+    return false;
+  // pixel major payloads skip the reference frame, and are always raw
+  if((flags & LB_FLAG_PIXEL_MAJOR) && (encoding != LB_ENCODING_RAW || payloadType != LB_PAYLOAD_RGB))
+    return false;
+  // compressed and palette payloads are checked once they are decoded
+  if(encoding == LB_ENCODING_RAW && !(flags & (LB_FLAG_LZ4 | LB_FLAG_PIXEL_MAJOR | LB_FLAG_PARITY | LB_FLAG_SYNC)) && !LbHasPalette(payloadType) && packetSize - headerSize != LbPayloadBytes(payloadType, numOfPixels))
+    return false;
+
+  return true;
+}
+
+PacketHeaderData ParsePacketHeader(const uint8_t packetBuf[], int packetSize)
+{
+  PacketHeaderData phd;
+  
+  phd.frameId = (*((const uint32_t *) (packetBuf + 8) ));
+  phd.segInFrame = (*((const uint32_t *) (packetBuf + 12) ));
+
+  phd.currSegId = (*((const uint32_t *) (packetBuf + 16) ));
+  phd.stripId = (*((const uint16_t *) (packetBuf + 20) ));
+  phd.pixelId = (*((const uint16_t *) (packetBuf + 22) ));
+
+  phd.protocolVersion = LB_PROTOCOL_VERSION(packetBuf[7]);
+  phd.payloadType = LB_PAYLOAD_TYPE(packetBuf[7]);
+
+  if(phd.protocolVersion == 0) {
+    const LedBurnPixelGroup *group = &lbPixelGroup[phd.payloadType];
+    phd.encoding = LB_ENCODING_RAW;
+    phd.flags = 0;
+    phd.refFrameId = 0;
+    phd.presentationUs = 0;
+    phd.numOfPixels = (packetSize - LB_HEADER_SIZE) / group->bytes * group->pixels;
+    phd.payload = packetBuf + LB_HEADER_SIZE;
+    phd.payloadLength = packetSize - LB_HEADER_SIZE;
+    return phd;
+  }
+
+  phd.encoding = packetBuf[24];
+  phd.flags = packetBuf[25];
+  phd.numOfPixels = (*((const uint16_t *) (packetBuf + 26) ));
+  phd.refFrameId = (*((const uint32_t *) (packetBuf + 28) ));
+  phd.payload = packetBuf + LB_V1_HEADER_SIZE;
+  phd.payloadLength = packetSize - LB_V1_HEADER_SIZE;
+  phd.presentationUs = 0;
+  if(phd.flags & LB_FLAG_PRESENTATION_TIME) {
+    memcpy(&phd.presentationUs, phd.payload, LB_PRESENTATION_TIME_SIZE);
+    phd.payload += LB_PRESENTATION_TIME_SIZE;
+    phd.payloadLength -= LB_PRESENTATION_TIME_SIZE;
+  }
+
+  return phd;
+}
+
+// return true if packet is ok.
+// return false if packet should be ignored
+bool BeforePaintLeds(const PacketHeaderData *phd)
+{
+  if(phd->segInFrame >= MAX_SUPPORTED_SEGMENTS || phd->currSegId >= phd->segInFrame) {
+    counters.invalidPackets++;
+    return false;
+  }
+
+  // our last frame waits for the other senders, the PRU buffer or its presentation time, but we are
+  // already sending the next one. keep it until that frame is committed
+  if(HoldsDatagrams() && HoldDatagram())
+    return false;
+  
+  // this is the common case with no packet losses
+  if(phd->frameId == session->currentFrame)
+    return true;
+  
+  // if the current frame is old. don't use it!
+  // do the math with int64, to avoid overflows
+  // unless it's very old, in which case, assume the sender restarted and use it
+  int64_t diffFromCurrent = (int64_t)phd->frameId - (int64_t)session->currentFrame;
+  if(diffFromCurrent > -500 && diffFromCurrent < 0) { // 500 is 10 seconds in 50HZ
+    counters.lateSegments++;
+    return false;
+  }
+
+  // if we are here, then this frame is not what we expected, but it is not frame from udp re-order.
+  // so we change our reference point to it!
+  metrics_add(referenceResetsMetric, 1);
+  ResetCounter(phd->frameId);
+  SendColorsToStrips(); // use the leds we already recived
+
+  if(diffFromCurrent < -500 || diffFromCurrent > 500) {
+  	SetAllSameColor(0, 0, 0);
+  }
+  return true;
+}
+
+// bytes of the largest payload that fits in a strand
+size_t MaxStripPayloadBytes()
+{
+  size_t bytes = 0;
+  for(int t=0; t<LB_NUM_OF_PAYLOAD_TYPES; t++) {
+    const size_t typeBytes = LbPayloadBytes(t, pixelsPerStrand);
+    if(typeBytes > bytes)
+      bytes = typeBytes;
+  }
+  return bytes;
+}
+
+// expand a palette payload to RGB pixels in the reference frame, and paint it from there as an RGB payload.
+// return false if the payload is malformed
+bool ExpandPalette(PacketHeaderData *phd)
+{
+  if(phd->payloadLength < 1)
+    return false;
+  const bool fourBit = phd->payloadType == LB_PAYLOAD_PALETTE4;
+  const int entries = phd->payload[0] ? phd->payload[0] : 256;
+  if(fourBit && entries > PALETTE4_ENTRIES)
+    return false;
+  if(phd->payloadLength != 1 + entries * 3 + LbPayloadBytes(phd->payloadType, phd->numOfPixels))
+    return false;
+
+  if(phd->pixelId >= pixelsPerStrand)
+    return true; // PaintLeds ignores it
+  const int numOfPixels = min(phd->numOfPixels, pixelsPerStrand - phd->pixelId);
+
+  // entries that were not sent are black
+  static uint8_t table[PALETTE8_ENTRIES * 3];
+  memcpy(table, phd->payload + 1, entries * 3);
+  memset(table + entries * 3, 0, sizeof(table) - entries * 3);
+
+  uint8_t *rgb = delta_cur_strip(delta, phd->stripId) + phd->pixelId * 3;
+  const uint8_t *indices = phd->payload + 1 + entries * 3;
+  if(fourBit)
+    palette_expand4(table, indices, rgb, numOfPixels);
+  else
+    palette_expand8(table, indices, rgb, numOfPixels);
+
+  phd->payloadType = LB_PAYLOAD_RGB;
+  phd->numOfPixels = numOfPixels;
+  phd->payload = rgb;
+  phd->payloadLength = numOfPixels * 3;
+  return true;
+}
+
+// keep the segment payload in the delta cache, decoding it first if it is delta encoded,
+// and point the payload at the pixels.
+// return false if the segment can not be decoded
+bool DecodeSegment(PacketHeaderData *phd)
+{
+  if(delta == NULL) {
+    if(phd->protocolVersion == 0)
+      return true;
+    printf("info: first version 1 packet, allocating delta reference frames\n");
+    delta = delta_init(numStrips, MaxStripPayloadBytes());
+  }
+
+  if(phd->stripId >= numStrips)
+    return true; // PaintLeds ignores it
+  session->deltaRef.cur_frame_id = phd->frameId;
+  session->deltaRef.cur_painted = true;
+
+  const LedBurnPixelGroup *group = &lbPixelGroup[phd->payloadType];
+  const size_t offset = phd->pixelId / group->pixels * group->bytes;
+  const size_t length = LbPayloadBytes(phd->payloadType, phd->numOfPixels);
+  const int wireLength = phd->payloadLength;
+  struct timespec start, end;
+
+  if(phd->flags & LB_FLAG_LZ4) {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    const int decompressed = lz4_block_decompress(phd->payload, phd->payloadLength, lz4Scratch, sizeof(lz4Scratch));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    delta->lz4_ns += (end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec);
+    if(decompressed < 0) {
+      delta->decode_errors++;
+      return false;
+    }
+    delta->lz4_segments++;
+    delta->lz4_wire_bytes += phd->payloadLength;
+    delta->lz4_bytes += decompressed;
+    phd->payload = lz4Scratch;
+    phd->payloadLength = decompressed;
+  }
+
+  if(phd->flags & LB_FLAG_PIXEL_MAJOR) {
+    // painted straight into the frame. numOfPixels is the number of rows
+    if(phd->payloadLength % (phd->numOfPixels * sizeof(ledscape_pixel_t)) != 0) {
+      delta->decode_errors++;
+      return false;
+    }
+    session->deltaRef.cur_uncached = true;
+    delta->segments++;
+    delta->wire_bytes += wireLength;
+    delta->raw_bytes += phd->payloadLength;
+    return true;
+  }
+
+  if(LbHasPalette(phd->payloadType)) {
+    if(!ExpandPalette(phd)) {
+      delta->decode_errors++;
+      return false;
+    }
+    delta->segments++;
+    delta->wire_bytes += wireLength;
+    delta->raw_bytes += phd->payloadLength;
+    return true;
+  }
+
+  uint8_t *cached = delta_cur_strip(delta, phd->stripId) + offset;
+  if(phd->encoding == LB_ENCODING_RAW) {
+    if(phd->payloadLength != (int)length) {
+      delta->decode_errors++;
+      return false;
+    }
+    // version 0 payloads may start in the middle of a group, and are not cached
+    if(phd->pixelId % group->pixels == 0 && offset < delta->strip_size)
+      memcpy(cached, phd->payload, min(length, delta->strip_size - offset));
+    else
+      session->deltaRef.cur_uncached = true;
+    delta->segments++;
+    delta->wire_bytes += wireLength;
+    delta->raw_bytes += length;
+    return true;
+  }
+
+  if(!session->deltaRef.ref_valid || phd->refFrameId != session->deltaRef.ref_frame_id) {
+    delta->ref_misses++;
+    return false;
+  }
+  if(offset + length > delta->strip_size) {
+    delta->decode_errors++;
+    return false;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  const bool decoded = delta_decode_xor_rle(
+    phd->payload,
+    phd->payloadLength,
+    delta_ref_strip(delta, phd->stripId) + offset,
+    cached,
+    length
+  );
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  delta->decode_ns += (end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec);
+
+  if(!decoded) {
+    // the cache holds part of a broken segment. the frame won't be complete, so it won't become a reference
+    delta->decode_errors++;
+    return false;
+  }
+
+  delta->segments++;
+  delta->wire_bytes += wireLength;
+  delta->raw_bytes += length;
+  phd->payload = cached;
+  return true;
+}
+
+static inline uint8_t AddSaturate(uint8_t a, uint8_t b)
+{
+	const unsigned sum = (unsigned)a + b;
+	return sum > 255 ? 255 : sum;
+}
+
+void PaintLedsRgbw(const uint8_t *payload, uint16_t stripId, uint16_t pixelId, int numOfPixels)
+{
+	if(rgbwOutput)
+	{
+		for(int i=0; i<numOfPixels; i++)
+		{
+			const uint8_t *pixelStartPointer = payload + i * 4;
+			ledscape_set_color_rgbw(
+				frame,
+				numStrips,
+				stripId,
+				pixelId + i,
+				*(pixelStartPointer+0),
+				*(pixelStartPointer+1),
+				*(pixelStartPointer+2),
+				*(pixelStartPointer+3)
+			);
+		}
+		return;
+	}
+
+	// RGBW sender driving RGB strips - mix the white back into the color channels
+	for(int i=0; i<numOfPixels; i++)
+	{
+		const uint8_t *pixelStartPointer = payload + i * 4;
+		const uint8_t w = *(pixelStartPointer+3);
+		ledscape_set_color(
+			frame,
+			numStrips,
+			COLOR_ORDER_BRG,
+			stripId,
+			pixelId + i,
+			AddSaturate(*(pixelStartPointer+0), w),
+			AddSaturate(*(pixelStartPointer+1), w),
+			AddSaturate(*(pixelStartPointer+2), w)
+		);
+	}
+}
+
+// write 16 or 12 bit pixels into the high depth cache. they reach the frame when it is sent
+void PaintLedsHighDepth(const uint8_t *payload, const PacketHeaderData *phd, int numOfPixels)
+{
+	if(dither == NULL) {
+		printf("info: first high bit depth payload, allocating high depth frame (gamma %.2f)\n", highDepthGamma);
+		dither = dither_init(numStrips, pixelsPerStrand, highDepthGamma);
+	}
+	highDepthStrip[phd->stripId] = true;
+
+	dither_pixel_t *out = dither_strip(dither, phd->stripId) + phd->pixelId;
+
+	if(phd->payloadType == LB_PAYLOAD_RGB16)
+	{
+		for(int i=0; i<numOfPixels; i++)
+		{
+			const uint8_t *pixelStartPointer = payload + i * 6;
+			out[i].r = pixelStartPointer[0] | (pixelStartPointer[1] << 8);
+			out[i].g = pixelStartPointer[2] | (pixelStartPointer[3] << 8);
+			out[i].b = pixelStartPointer[4] | (pixelStartPointer[5] << 8);
+		}
+		return;
+	}
+
+	// 12 bit: every 3 bytes hold two channels, low nibble first
+	uint16_t channels[6];
+	for(int i=0; i<numOfPixels; i += 2)
+	{
+		const uint8_t *groupStartPointer = payload + (i / 2) * 9;
+		for(int c=0; c<3; c++)
+		{
+			const uint8_t *pairStartPointer = groupStartPointer + c * 3;
+			const uint32_t pair = pairStartPointer[0] | (pairStartPointer[1] << 8) | (pairStartPointer[2] << 16);
+			channels[c * 2 + 0] = dither_expand12(pair & 0xFFF);
+			channels[c * 2 + 1] = dither_expand12(pair >> 12);
+		}
+		out[i].r = channels[0];
+		out[i].g = channels[1];
+		out[i].b = channels[2];
+		// numOfPixels was clipped to the strand, so the second pixel may be out of range
+		if(i + 1 < numOfPixels) {
+			out[i + 1].r = channels[3];
+			out[i + 1].g = channels[4];
+			out[i + 1].b = channels[5];
+		}
+	}
+}
+
+// the payload is numOfPixels rows of the frame, from pixelId, each covering payloadLength / numOfPixels / 4
+// strips of the stream from stripId, in the PRU order (ledscape_pixel_t). the columns of our strips,
+// [stripOffset, stripOffset + numStrips), are copied. rows that are exactly our strips are one copy
+void PaintLedsPixelMajor(const PacketHeaderData *phd)
+{
+	const unsigned rowStrips = phd->payloadLength / phd->numOfPixels / sizeof(ledscape_pixel_t);
+	const unsigned first = max(phd->stripId, stripOffset);
+	const unsigned end = min(phd->stripId + rowStrips, stripOffset + numStrips);
+	if(first >= end || phd->pixelId >= pixelsPerStrand)
+		return;
+	const int numOfRows = min(phd->numOfPixels, pixelsPerStrand - phd->pixelId);
+	const unsigned ourStrips = end - first;
+
+	for(unsigned s = first - stripOffset; s < end - stripOffset; s++)
+		highDepthStrip[s] = false;
+
+	ledscape_pixel_t *out = ledscape_pixel(frame, numStrips, first - stripOffset, phd->pixelId);
+	const uint8_t *in = phd->payload + (first - phd->stripId) * sizeof(ledscape_pixel_t);
+	if(rowStrips == numStrips && ourStrips == numStrips) {
+		memcpy(out, in, numOfRows * numStrips * sizeof(ledscape_pixel_t));
+		return;
+	}
+
+	const size_t rowBytes = rowStrips * sizeof(ledscape_pixel_t);
+	for(int row = 0; row < numOfRows; row++, out += numStrips)
+		memcpy(out, in + row * rowBytes, ourStrips * sizeof(ledscape_pixel_t));
+}
+
+void PaintLeds(const PacketHeaderData *phd)
+{
+	if(phd->flags & LB_FLAG_PIXEL_MAJOR)
+	{
+		PaintLedsPixelMajor(phd);
+		return;
+	}
+
+	// avoid overrun the allowed buffer
+	if(phd->stripId >= numStrips)
+		return;
+	if(phd->pixelId >= pixelsPerStrand)
+		return;
+	int numOfPixels = min(phd->numOfPixels, (uint16_t)(pixelsPerStrand - phd->pixelId) ); // pixelsPerStrand - phd.pixelId > 0
+
+	const uint8_t *bufStartPointer = phd->payload;
+
+	if(phd->payloadType == LB_PAYLOAD_RGB16 || phd->payloadType == LB_PAYLOAD_RGB12)
+	{
+		PaintLedsHighDepth(bufStartPointer, phd, numOfPixels);
+		return;
+	}
+
+	// an 8 bit payload takes the strip back from the high depth cache
+	highDepthStrip[phd->stripId] = false;
+
+	if(phd->payloadType == LB_PAYLOAD_RGBW)
+	{
+		PaintLedsRgbw(bufStartPointer, phd->stripId, phd->pixelId, numOfPixels);
+		return;
+	}
+
+	if(rgbwOutput)
+	{
+		// RGB sender driving RGBW strips - extract the white channel on the device
+		for(int i=0; i<numOfPixels; i++)
+		{
+			const uint8_t *pixelStartPointer = bufStartPointer + i * 3;
+			ledscape_set_color_rgb_to_rgbw(
+				frame,
+				numStrips,
+				phd->stripId,
+				phd->pixelId + i,
+				*(pixelStartPointer+0),
+				*(pixelStartPointer+1),
+				*(pixelStartPointer+2)
+			);
+		}
+		return;
+	}
+
+	for(int i=0; i<numOfPixels; i++)
+	{
+		const uint8_t *pixelStartPointer = bufStartPointer + i * 3;
+		ledscape_set_color(
+			frame,
+			numStrips,
+			COLOR_ORDER_BRG,
+			phd->stripId,
+			phd->pixelId + i,
+			*(pixelStartPointer+0),
+			*(pixelStartPointer+1),
+			*(pixelStartPointer+2)
+		);
+	}
+}
+
+void AfterPaintLeds(const PacketHeaderData *phd)
+{
+  if(phd->presentationUs)
+    session->framePresentationUs = phd->presentationUs;
+
+  if(SegmentReceived(phd->currSegId))
+  {
+    // we already have this segment. this is a duplicate packet!
+    counters.duplicateSegments++;
+    return;
+  }
+
+  session->receivedSegGen[phd->currSegId] = session->segGeneration;
+  session->numOfReceivedSegments++;
+  counters.segments++;
+
+  const uint64_t rxUs = packetRxUs ? packetRxUs : clocksync_now_us(CLOCK_REALTIME);
+  if(session->firstSegmentUs == 0)
+    session->firstSegmentUs = rxUs;
+  session->lastSegmentUs = rxUs;
+  session->currentSegInFrame = phd->segInFrame;
+
+  if(!session->syncMode && session->numOfReceivedSegments >= phd->segInFrame)
+  {
+  	CommitSessionFrame();
+  }
+}
+
+// resolve --clock-master host[:port], as an IPv6 (or v4 mapped) address for the dual stack socket
+void ResolveClockMaster()
+{
+	char host[256];
+	const char *port = "2001";
+	snprintf(host, sizeof(host), "%s", clockMaster);
+	char *colon = strrchr(host, ':');
+	// a single colon separates the port. IPv6 addresses with a port are written [addr]:port
+	if(colon != NULL && (strchr(host, ':') == colon || (host[0] == '[' && colon > host && colon[-1] == ']'))) {
+		*colon = '\0';
+		port = colon + 1;
+	}
+	char *name = host;
+	if(name[0] == '[') {
+		name++;
+		name[strlen(name) - 1] = '\0';
+	}
+
+	struct addrinfo hints, *res;
+	bzero(&hints, sizeof(hints));
+	hints.ai_family = AF_INET6;
+	hints.ai_socktype = SOCK_DGRAM;
+	hints.ai_flags = AI_V4MAPPED;
+	const int rc = getaddrinfo(name, port, &hints, &res);
+	if(rc != 0)
+		die("[clock] unable to resolve clock master %s: %s\n", clockMaster, gai_strerror(rc));
+	memcpy(&clockMasterAddr, res->ai_addr, sizeof(clockMasterAddr));
+	freeaddrinfo(res);
+}
+
+void PollClockSync(int sock)
+{
+	const uint64_t now = clocksync_now_us(CLOCK_MONOTONIC);
+	if(!clocksync_request_due(&clockSync, now, CLOCK_SYNC_INTERVAL_US))
+		return;
+	uint8_t request[CLOCKSYNC_PACKET_SIZE];
+	const size_t len = clocksync_make_request(&clockSync, request, now);
+	if(sendto(sock, request, len, 0, (const struct sockaddr *) &clockMasterAddr, sizeof(clockMasterAddr)) < 0)
+		warn_once("[clock] sending to clock master failed: %s\n", strerror(errno));
+}
+
+void HandleClockSyncReply(const uint8_t buf[])
+{
+	if(!clocksync_handle_reply(&clockSync, buf, clocksync_now_us(CLOCK_MONOTONIC)))
+		return;
+	if(clockSync.replies % CLOCK_STATS_INTERVAL != 0)
+		return;
+	printf("info: clock: offset %" PRId64 " us, jitter %.1f us, round trip %" PRId64 " us, %" PRIu64 " bad replies. "
+		"%" PRIu64 " frames presented, %" PRIu64 " late, up to %" PRId64 " us\n",
+		clockSync.offset_us, clockSync.jitter_us, clockSync.delay_us, clockSync.bad_replies,
+		presentedFrames, lateFrames, maxLatenessUs);
+	maxLatenessUs = 0;
+}
+
+// true if the waiting frame should be sent now. frames without a presentation time, or before the clock
+// is synced, are sent as soon as they are complete
+bool IsPresentationDue()
+{
+	if(pendingPresentationUs == 0 || !clockSync.synced)
+		return true;
+
+	const int64_t untilPresentation = (int64_t)(clocksync_to_local(&clockSync, pendingPresentationUs) - clocksync_now_us(CLOCK_MONOTONIC));
+	if(untilPresentation > PRESENTATION_MAX_WAIT_US) {
+		warn_once("[clock] presentation time is %" PRId64 " us ahead. is the sender synced with the clock master?\n", untilPresentation);
+		return true;
+	}
+	if(untilPresentation > 0)
+		return false;
+
+	presentedFrames++;
+	if(-untilPresentation > PRESENTATION_LATE_US)
+		lateFrames++;
+	if(-untilPresentation > maxLatenessUs)
+		maxLatenessUs = -untilPresentation;
+	return true;
+}
+
+// answer clock sync requests, as a stand-in clock master for testing. never returns
+void ServeClock(int port)
+{
+	const int sock = socket(AF_INET6, SOCK_DGRAM, 0);
+	if (sock < 0)
+		die("[clock] socket failed: %s\n", strerror(errno));
+
+	struct sockaddr_in6 addr;
+	bzero(&addr, sizeof(addr));
+	addr.sin6_family = AF_INET6;
+	addr.sin6_addr = in6addr_any;
+	addr.sin6_port = htons(port);
+	if (bind(sock, (const struct sockaddr*) &addr, sizeof(addr)) < 0)
+		die("[clock] bind port %d failed: %s\n", port, strerror(errno));
+
+	printf("[clock] serving clock sync requests on port %d\n", port);
+	for(;;) {
+		uint8_t buf[CLOCKSYNC_PACKET_SIZE + 1];
+		struct sockaddr_in6 from;
+		socklen_t fromLength = sizeof(from);
+		const ssize_t rc = recvfrom(sock, buf, sizeof(buf), 0, (struct sockaddr *) &from, &fromLength);
+		const uint64_t received = clocksync_now_us(CLOCK_REALTIME);
+		if(rc < 0 || !clocksync_is_packet(buf, rc, CLOCKSYNC_REQUEST))
+			continue;
+		clocksync_make_reply(buf, received, clocksync_now_us(CLOCK_REALTIME));
+		sendto(sock, buf, CLOCKSYNC_PACKET_SIZE, 0, (const struct sockaddr *) &from, fromLength);
+	}
+}
+
+void JoinMulticastGroup(int sock, const char *group)
+{
+	unsigned ifindex = 0;
+	if(multicastInterface != NULL) {
+		ifindex = if_nametoindex(multicastInterface);
+		if(ifindex == 0)
+			die("[udp] unknown multicast interface %s: %s\n", multicastInterface, strerror(errno));
+	}
+
+	struct in_addr group4;
+	struct in6_addr group6;
+	if(inet_pton(AF_INET, group, &group4) == 1) {
+		// the socket is dual stack, so it takes IPv4 memberships as well
+		struct ip_mreqn mreq;
+		bzero(&mreq, sizeof(mreq));
+		mreq.imr_multiaddr = group4;
+		mreq.imr_ifindex = ifindex;
+		if(setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0 && errno != EADDRINUSE)
+			die("[udp] join multicast group %s failed: %s%s\n", group, strerror(errno),
+				errno == ENOBUFS ? ". raise net.ipv4.igmp_max_memberships" : "");
+	}
+	else if(inet_pton(AF_INET6, group, &group6) == 1) {
+		struct ipv6_mreq mreq;
+		bzero(&mreq, sizeof(mreq));
+		mreq.ipv6mr_multiaddr = group6;
+		mreq.ipv6mr_interface = ifindex;
+		if(setsockopt(sock, IPPROTO_IPV6, IPV6_JOIN_GROUP, &mreq, sizeof(mreq)) < 0)
+			die("[udp] join multicast group %s failed: %s\n", group, strerror(errno));
+	}
+	else {
+		die("[udp] multicast group %s is not an IPv4 or IPv6 address\n", group);
+	}
+
+}
+
+// segments for strips of other controllers only count towards the frame.
+// the strip id of our segments is made relative to our first strip, except for pixel major
+// segments: their rows may start on an earlier controller's strips, and how many strips they
+// cover is only known once decoded, so PaintLedsPixelMajor slices out our strips
+bool IsOurSegment(PacketHeaderData *phd)
+{
+	if(phd->flags & LB_FLAG_PIXEL_MAJOR)
+		return phd->stripId < stripOffset + numStrips;
+	if(phd->stripId < stripOffset || phd->stripId >= stripOffset + numStrips)
+		return false;
+	phd->stripId -= stripOffset;
+	return true;
+}
+
+// commit the frame being received, like an ArtSync. the sender decides when frames latch,
+// whatever the number of segments or senders. syncs of other frames are ignored
+void HandleSync(const PacketHeaderData *phd)
+{
+	// a sync of our next frame, while the last one waits
+	if(HoldsDatagrams() && HoldDatagram())
+		return;
+	if(!session->syncMode) {
+		printf("info: first sync packet, frames of this sender are now committed by sync packets\n");
+		session->syncMode = true;
+	}
+	if(phd->frameId != session->currentFrame)
+		return;
+
+	// segments that were lost are not in the frame, so it can't be a delta reference
+	if(session->numOfReceivedSegments < session->currentSegInFrame)
+		session->deltaRef.cur_uncached = true;
+
+	if(phd->presentationUs)
+		session->framePresentationUs = phd->presentationUs;
+	CommitSessionFrame();
+	FlushFrames();
+}
+
+void PaintOurSegment(PacketHeaderData *phd)
+{
+	if(!DecodeSegment(phd))
+	{
+	  counters.decodeFailures++;
+	  return;
+	}
+	PROFILE_START(paintStart);
+	PaintLeds(phd);
+	PROFILE_END(STAGE_PAINT, paintStart);
+	PROFILE_START(afterPaintStart);
+	AfterPaintLeds(phd);
+	PROFILE_END(STAGE_AFTER_PAINT, afterPaintStart);
+}
+
+void PaintSegment(PacketHeaderData *phd)
+{
+	if(!IsOurSegment(phd))
+	{
+	  PROFILE_START(afterPaintStart);
+	  AfterPaintLeds(phd);
+	  PROFILE_END(STAGE_AFTER_PAINT, afterPaintStart);
+	  return;
+	}
+	PaintOurSegment(phd);
+}
+
+void HandleLedBurnPacket(const uint8_t buf[], int len);
+
+// a held LedBurn datagram
+void HandleLedBurnPacketFrom(const uint8_t buf[], int len, const struct sockaddr_in6 *from)
+{
+	packetFrom = *from;
+	HandleLedBurnPacket(buf, len);
+}
+
+// rebuild the missing segment of a parity group, once all the others and the parity arrived
+void TryFecRecovery(int first)
+{
+	if(first < 0)
+		return;
+	const size_t len = fec_recover(session->fec, first, fecRecovered);
+	if(len > 0)
+		HandleLedBurnPacket(fecRecovered, len);
+}
+
+void HandleLedBurnPacket(const uint8_t buf[], int len)
+{
+	handled = (HandledDatagram) { HandleLedBurnPacketFrom, buf, len, &packetFrom };
+	PROFILE_START(verifyStart);
+	const bool valid = VerifyLedBurnPacket(buf, len);
+	PROFILE_END(STAGE_VERIFY, verifyStart);
+	if(!valid)
+	{
+		counters.invalidPackets++;
+		return;
+	}
+	telemetryPeer = packetFrom;
+	telemetryHasPeer = true;
+	session = FindSession(&packetFrom);
+	
+	PacketHeaderData phd = ParsePacketHeader(buf, len);
+	if(phd.flags & LB_FLAG_SYNC)
+	{
+	  HandleSync(&phd);
+	  return;
+	}
+	if(!BeforePaintLeds(&phd))
+	  return;
+
+	if(phd.flags & LB_FLAG_PARITY)
+	{
+	  if(session->fec == NULL) {
+	    printf("info: first parity segment, allocating fec arena\n");
+	    session->fec = fec_init(MAX_SUPPORTED_SEGMENTS, FEC_ARENA_SIZE);
+	  }
+	  fec_add_parity(session->fec, phd.currSegId, phd.numOfPixels, phd.payload, phd.payloadLength);
+	  TryFecRecovery(phd.currSegId);
+	  return;
+	}
+	if(session->fec != NULL)
+	  fec_add_data(session->fec, phd.currSegId, buf, len);
+
+	PaintSegment(&phd);
+
+	if(session->fec != NULL)
+	  TryFecRecovery(fec_group_of(session->fec, phd.currSegId));
+}
+
+// paint a universe as an RGB segment of the session's frame, which is made of all the mapped universes.
+// a universe some other source leads is painted, but doesn't count towards the frame
+void PaintUniverse(const universe_map_t *map, const universe_range_t *range, const uint8_t *data, uint16_t length, bool segment)
+{
+	PacketHeaderData phd;
+	memset(&phd, 0, sizeof(phd));
+	phd.segInFrame = map->num_mapped;
+	phd.currSegId = range->segment;
+	phd.stripId = range->strip;
+	phd.pixelId = range->pixel;
+	phd.payloadType = LB_PAYLOAD_RGB;
+	phd.numOfPixels = min(range->num_pixels, length / 3);
+	phd.payload = data;
+	phd.payloadLength = phd.numOfPixels * 3;
+
+	// without frame ids, a universe we already have means the sender moved on to the next frame,
+	// and some universe of this one was lost. commit what we have
+	if(segment && !session->syncMode && SegmentReceived(phd.currSegId))
+	{
+	  session->deltaRef.cur_uncached = true;
+	  CommitSessionFrame();
+	}
+	phd.frameId = session->currentFrame;
+	if(!segment)
+	{
+	  if(DecodeSegment(&phd))
+	    PaintLeds(&phd);
+	  return;
+	}
+	if(!BeforePaintLeds(&phd))
+	  return;
+	PaintOurSegment(&phd);
+}
+
+// an ArtDmx universe is a segment of the sender's frame. the frame is committed when all the mapped
+// universes arrived, or by ArtSync once the sender sends it
+void HandleArtNetPacket(const uint8_t buf[], int len, const struct sockaddr_in6 *from)
+{
+	artnet_packet_t packet;
+	if(!artnet_parse(buf, len, &packet))
+		return; // ArtPoll and the rest of the opcodes are not for us
+	session = FindSession(from);
+	handled = (HandledDatagram) { HandleArtNetPacket, buf, len, from };
+
+	if(packet.opcode == ARTNET_OP_SYNC)
+	{
+	  PacketHeaderData phd;
+	  memset(&phd, 0, sizeof(phd));
+	  phd.frameId = session->currentFrame;
+	  HandleSync(&phd);
+	  return;
+	}
+
+	const universe_range_t *range = universe_map_lookup(artnetMap, packet.universe);
+	if(range == NULL)
+	  return; // a universe of another controller
+	PaintUniverse(artnetMap, range, packet.data, packet.length, true);
+}
+
+// join the multicast group of an E1.31 universe
+void JoinE131Universe(uint16_t universe)
+{
+	char group[16];
+	e131_multicast_group(universe, group);
+	JoinMulticastGroup(e131Sock, group);
+}
+
+// E1.31 sources are merged per universe before painting, so all of them make up a single session's frames.
+// a frame is committed when all the mapped universes arrived from the sources leading them, or by sync packets
+void HandleE131Packet(const uint8_t buf[], int len, const struct sockaddr_in6 *from)
+{
+	e131_packet_t packet;
+	if(!e131_parse(buf, len, &packet))
+		return;
+	session = FindSession(&e131Session);
+	handled = (HandledDatagram) { HandleE131Packet, buf, len, from };
+
+	if(packet.type == E131_SYNC)
+	{
+	  if(packet.sync_universe != e131SyncUniverse)
+	    return;
+	  PacketHeaderData phd;
+	  memset(&phd, 0, sizeof(phd));
+	  phd.frameId = session->currentFrame;
+	  HandleSync(&phd);
+	  return;
+	}
+
+	const universe_range_t *range = universe_map_lookup(e131Map, packet.universe);
+	if(range == NULL)
+	  return;
+	if(packet.sync_universe != 0 && packet.sync_universe != e131SyncUniverse)
+	{
+	  // sync packets go to the sync universe's group
+	  e131SyncUniverse = packet.sync_universe;
+	  if(universe_map_lookup(e131Map, e131SyncUniverse) == NULL)
+	    JoinE131Universe(e131SyncUniverse);
+	}
+
+	uint16_t length;
+	bool lead;
+	const uint8_t *data = e131_merge(e131Merge, range->segment, &packet, clocksync_now_us(CLOCK_MONOTONIC), &length, &lead);
+	if(data != NULL)
+	  PaintUniverse(e131Map, range, data, length, lead);
+}
+
+// the universe map of a DMX receiver, from the --universe-map file, or in order from its first universe
+universe_map_t *InitUniverseMap(const char *name, int firstUniverse, unsigned maxUniverse)
+{
+	universe_map_t *map;
+	if(universeMapFile != NULL) {
+		map = universe_map_load(universeMapFile, numStrips, pixelsPerStrand);
+	}
+	else {
+		const unsigned universesPerStrip = (pixelsPerStrand + universePixels - 1) / universePixels;
+		if(firstUniverse + numStrips * universesPerStrip - 1 > maxUniverse)
+			die("[%s] %u universes from %d don't fit, use more pixels per universe\n", name, numStrips * universesPerStrip, firstUniverse);
+		map = universe_map_init(firstUniverse, numStrips, pixelsPerStrand, universePixels);
+	}
+	if(map->first_universe + map->num_universes - 1 > maxUniverse)
+		die("[%s] universes go up to %u\n", name, maxUniverse);
+	// BeforePaintLeds takes frames of fewer than MAX_SUPPORTED_SEGMENTS segments
+	if(map->num_mapped >= MAX_SUPPORTED_SEGMENTS)
+		die("[%s] %u universes are more than the %d segments of a frame\n", name, map->num_mapped, MAX_SUPPORTED_SEGMENTS - 1);
+	return map;
+}
+
+// map the universes of --artnet and --e131 onto our strips, once the strand length is known
+void InitUniverseMaps()
+{
+	if(artnetUniverse >= 0)
+		artnetMap = InitUniverseMap("artnet", artnetUniverse, ARTNET_MAX_UNIVERSE);
+	if(e131Universe >= 0) {
+		e131Map = InitUniverseMap("e131", e131Universe, E131_MAX_UNIVERSE);
+		e131Merge = e131_merge_init(e131Map->num_mapped, e131MergePolicy);
+	}
+}
+
+int OpenReceiverSocket(const char *name, int port, const universe_map_t *map)
+{
+	const int sock = socket(AF_INET6, SOCK_DGRAM, 0);
+	if (sock < 0)
+		die("[%s] socket failed: %s\n", name, strerror(errno));
+	fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+
+	struct sockaddr_in6 addr;
+	bzero(&addr, sizeof(addr));
+	addr.sin6_family = AF_INET6;
+	addr.sin6_addr = in6addr_any;
+	addr.sin6_port = htons(port);
+	if (bind(sock, (const struct sockaddr*) &addr, sizeof(addr)) < 0)
+		die("[%s] bind port %d failed: %s\n", name, port, strerror(errno));
+
+	if(map != NULL)
+		printf("[%s] %u universes from %u to %u, on port %d\n", name, map->num_mapped, map->first_universe,
+			map->first_universe + map->num_universes - 1, port);
+	else
+		printf("[%s] listening on port %d\n", name, port);
+	return sock;
+}
+
+// drain a DMX receiver's socket, a batch of datagrams per system call. a universe is only 170 pixels,
+// so there are many of them
+void PollReceiver(int sock, void (*handle)(const uint8_t buf[], int len, const struct sockaddr_in6 *from))
+{
+	static uint8_t bufs[RECV_BATCH][RECV_DATAGRAM_SIZE];
+	static struct sockaddr_in6 from[RECV_BATCH];
+	static struct iovec iov[RECV_BATCH];
+	static struct mmsghdr msgs[RECV_BATCH];
+
+	for(;;) {
+		for(int i=0; i<RECV_BATCH; i++) {
+			iov[i].iov_base = bufs[i];
+			iov[i].iov_len = sizeof(bufs[i]);
+			bzero(&msgs[i].msg_hdr, sizeof(msgs[i].msg_hdr));
+			msgs[i].msg_hdr.msg_name = &from[i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(from[i]);
+			msgs[i].msg_hdr.msg_iov = &iov[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+		const int received = recvmmsg(sock, msgs, RECV_BATCH, MSG_DONTWAIT, NULL);
+		if(received < 0) {
+			if(errno != EAGAIN && errno != EWOULDBLOCK)
+				fprintf(stderr, "[udp] recv failed: %s\n", strerror(errno));
+			return;
+		}
+		for(int i=0; i<received; i++)
+			handle(bufs[i], min(msgs[i].msg_len, sizeof(bufs[i])), &from[i]);
+		if(received < RECV_BATCH)
+			return;
+	}
+}
+
+// an OPC message is the single segment of the sender's frame
+PacketHeaderData OpcFrameSegment()
+{
+	PacketHeaderData phd;
+	memset(&phd, 0, sizeof(phd));
+	phd.frameId = session->currentFrame;
+	phd.segInFrame = 1;
+	phd.payloadType = LB_PAYLOAD_RGB;
+	return phd;
+}
+
+bool IsOpcFrame(const uint8_t header[OPC_HEADER_SIZE])
+{
+	return header[0] == OPC_CHANNEL_ALL && header[1] == OPC_SET_PIXELS;
+}
+
+// paint pixels of the strips one after the other, from the pixel at index first.
+// phd gives the frame and the payload type
+void PaintConcatenatedStrips(PacketHeaderData phd, const uint8_t *payload, unsigned first, unsigned numOfPixels)
+{
+	phd.stripId = first / pixelsPerStrand;
+	phd.pixelId = first % pixelsPerStrand;
+	while(numOfPixels > 0 && phd.stripId < numStrips) {
+		phd.numOfPixels = min(numOfPixels, (unsigned)(pixelsPerStrand - phd.pixelId));
+		phd.payload = payload;
+		phd.payloadLength = LbPayloadBytes(phd.payloadType, phd.numOfPixels);
+		if(DecodeSegment(&phd))
+			PaintLeds(&phd);
+		payload += phd.payloadLength;
+		numOfPixels -= phd.numOfPixels;
+		phd.stripId++;
+		phd.pixelId = 0;
+	}
+}
+
+void HandleOpcDatagram(const uint8_t buf[], int len, const struct sockaddr_in6 *from)
+{
+	if(len < OPC_HEADER_SIZE || !IsOpcFrame(buf))
+		return;
+	const unsigned length = min((unsigned)((buf[2] << 8) | buf[3]), (unsigned)len - OPC_HEADER_SIZE);
+	session = FindSession(from);
+	handled = (HandledDatagram) { HandleOpcDatagram, buf, len, from };
+	PacketHeaderData phd = OpcFrameSegment();
+	if(!BeforePaintLeds(&phd))
+		return;
+	PaintConcatenatedStrips(phd, buf + OPC_HEADER_SIZE, 0, length / 3);
+	AfterPaintLeds(&phd);
+}
+
+void CloseOpcClient(OpcClient *client)
+{
+	char name[INET6_ADDRSTRLEN];
+	inet_ntop(AF_INET6, &client->addr.sin6_addr, name, sizeof(name));
+	printf("[opc] [%s]:%u disconnected\n", name, ntohs(client->addr.sin6_port));
+	close(client->fd);
+	client->fd = 0;
+	ForgetSession(&client->addr);
+}
+
+// read what the connection has. large messages are painted a read at a time, straight from the
+// receive buffer, so they are never assembled
+void ReadOpcClient(OpcClient *client)
+{
+	session = FindSession(&client->addr);
+	handled.handler = NULL;
+	ssize_t rc;
+	for(;;) {
+		// our last frame waits. the next message stays in the socket until it is committed
+		if(client->headerBytes == 0 && session->frameReady)
+			return;
+		if(client->headerBytes < OPC_HEADER_SIZE) {
+			rc = recv(client->fd, client->header + client->headerBytes, OPC_HEADER_SIZE - client->headerBytes, 0);
+			if(rc <= 0)
+				break;
+			client->headerBytes += rc;
+			if(client->headerBytes < OPC_HEADER_SIZE)
+				continue;
+			client->length = (client->header[2] << 8) | client->header[3];
+			client->offset = 0;
+			client->dataBytes = 0;
+			if(IsOpcFrame(client->header)) {
+				PacketHeaderData phd = OpcFrameSegment();
+				BeforePaintLeds(&phd);
+			}
+		}
+		else {
+			rc = recv(client->fd, client->data + client->dataBytes,
+				min(sizeof(client->data) - client->dataBytes, client->length - client->offset - client->dataBytes), 0);
+			if(rc <= 0)
+				break;
+			client->dataBytes += rc;
+
+			// paint the whole pixels, and keep a partial one for the next read
+			unsigned used = client->dataBytes;
+			if(IsOpcFrame(client->header)) {
+				used -= used % 3;
+				PaintConcatenatedStrips(OpcFrameSegment(), client->data, client->offset / 3, used / 3);
+			}
+			client->offset += used;
+			client->dataBytes -= used;
+			memmove(client->data, client->data + used, client->dataBytes);
+		}
+
+		if(client->offset + client->dataBytes < client->length)
+			continue;
+		// the whole message arrived. bytes of a partial last pixel are dropped
+		if(IsOpcFrame(client->header)) {
+			PacketHeaderData phd = OpcFrameSegment();
+			AfterPaintLeds(&phd);
+		}
+		client->headerBytes = 0;
+	}
+
+	if(rc == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+		CloseOpcClient(client);
+}
+
+void AcceptOpcClients(int listenSock)
+{
+	for(;;) {
+		struct sockaddr_in6 addr;
+		socklen_t addrLength = sizeof(addr);
+		const int fd = accept(listenSock, (struct sockaddr *) &addr, &addrLength);
+		if(fd < 0) {
+			if(errno != EAGAIN && errno != EWOULDBLOCK)
+				fprintf(stderr, "[opc] accept failed: %s\n", strerror(errno));
+			return;
+		}
+
+		char name[INET6_ADDRSTRLEN];
+		inet_ntop(AF_INET6, &addr.sin6_addr, name, sizeof(name));
+		OpcClient *client = NULL;
+		for(int i=0; i<MAX_OPC_CLIENTS && client == NULL; i++) {
+			if(opcClients[i].fd == 0)
+				client = &opcClients[i];
+		}
+		if(client == NULL) {
+			fprintf(stderr, "[opc] [%s]:%u refused, %d clients are connected\n", name, ntohs(addr.sin6_port), MAX_OPC_CLIENTS);
+			close(fd);
+			continue;
+		}
+
+		printf("[opc] [%s]:%u connected\n", name, ntohs(addr.sin6_port));
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+		client->fd = fd;
+		client->addr = addr;
+		client->headerBytes = 0;
+	}
+}
+
+int OpenOpcListenSocket()
+{
+	const int sock = socket(AF_INET6, SOCK_STREAM, 0);
+	if (sock < 0)
+		die("[opc] socket failed: %s\n", strerror(errno));
+	const int one = 1;
+	setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+
+	struct sockaddr_in6 addr;
+	bzero(&addr, sizeof(addr));
+	addr.sin6_family = AF_INET6;
+	addr.sin6_addr = in6addr_any;
+	addr.sin6_port = htons(opcPort);
+	if (bind(sock, (const struct sockaddr*) &addr, sizeof(addr)) < 0)
+		die("[opc] bind port %d failed: %s\n", opcPort, strerror(errno));
+	if (listen(sock, MAX_OPC_CLIENTS) < 0)
+		die("[opc] listen failed: %s\n", strerror(errno));
+	return sock;
+}
+
+void PollOpc(int listenSock, int udpSock)
+{
+	static uint8_t datagram[65536];
+
+	AcceptOpcClients(listenSock);
+	for(int i=0; i<MAX_OPC_CLIENTS; i++) {
+		if(opcClients[i].fd != 0)
+			ReadOpcClient(&opcClients[i]);
+	}
+
+	for(;;) {
+		struct sockaddr_in6 from;
+		socklen_t fromLength = sizeof(from);
+		const ssize_t rc = recvfrom(udpSock, datagram, sizeof(datagram), MSG_DONTWAIT, (struct sockaddr *) &from, &fromLength);
+		if(rc < 0)
+			break;
+		HandleOpcDatagram(datagram, rc, &from);
+	}
+}
+
+// a DDP data packet is painted at its offset, into the strips one after the other. DDP has no segment
+// counts, so a packet is the segment at its offset, in segments of the sender's longest packet. the PUSH
+// flag commits the frame like a sync packet. frames of senders that never push are committed once all
+// our strips arrived, when a segment repeats, or when the sender pauses, see CommitPausedDdpFrames
+void HandleDdpPacket(const uint8_t buf[], int len, const struct sockaddr_in6 *from)
+{
+	ddp_packet_t packet;
+	if(!ddp_parse(buf, len, &packet))
+		return;
+	session = FindSession(from);
+	handled = (HandledDatagram) { HandleDdpPacket, buf, len, from };
+
+	// our last frame waits for the other senders, the PRU buffer or its presentation time
+	if(HoldsDatagrams() && HoldDatagram())
+		return;
+
+	session->ddp = true;
+	if(packet.flags & DDP_FLAG_PUSH)
+	  session->syncMode = true;
+
+	PacketHeaderData phd;
+	memset(&phd, 0, sizeof(phd));
+	phd.frameId = session->currentFrame;
+	phd.payloadType = packet.pixel_bytes == 4 ? LB_PAYLOAD_RGBW : LB_PAYLOAD_RGB;
+
+	// offsets are on pixel boundaries with every sender we know of. if not, the partial pixels are dropped
+	const unsigned skip = (packet.pixel_bytes - packet.offset % packet.pixel_bytes) % packet.pixel_bytes;
+	if(packet.length > skip)
+	{
+	  // however short the packets, a frame has fewer than MAX_SUPPORTED_SEGMENTS segments
+	  const unsigned frameBytes = numStrips * pixelsPerStrand * packet.pixel_bytes;
+	  const unsigned minSegmentBytes = frameBytes / (MAX_SUPPORTED_SEGMENTS - 1) + 1;
+	  session->ddpSegmentBytes = max(session->ddpSegmentBytes, max((unsigned)packet.length, minSegmentBytes));
+	  phd.segInFrame = (frameBytes + session->ddpSegmentBytes - 1) / session->ddpSegmentBytes;
+	  phd.currSegId = packet.offset / session->ddpSegmentBytes;
+
+	  // a segment we already have means the sender moved on to the next frame, and some of this one was lost
+	  if(phd.currSegId < phd.segInFrame && !session->syncMode && SegmentReceived(phd.currSegId))
+	  {
+	    session->deltaRef.cur_uncached = true;
+	    CommitSessionFrame();
+	  }
+
+	  // the bytes past our strips are not ours, and are not segments of our frames
+	  if(phd.currSegId < phd.segInFrame)
+	  {
+	    if(!BeforePaintLeds(&phd))
+	      return;
+	    PaintConcatenatedStrips(phd, packet.data + skip, (packet.offset + skip) / packet.pixel_bytes, (packet.length - skip) / packet.pixel_bytes);
+	    AfterPaintLeds(&phd);
+	  }
+	}
+
+	if(packet.flags & DDP_FLAG_PUSH)
+	  HandleSync(&phd);
+}
+
+// a DDP sender that never pushes, and sends fewer pixels than we have, paused: commit its frame
+void CommitPausedDdpFrames()
+{
+	const uint64_t now = clocksync_now_us(CLOCK_REALTIME);
+	for(int i=0; i<MAX_SESSIONS; i++) {
+		LedBurnSession *ddpSession = &sessions[i];
+		if(!ddpSession->inUse || !ddpSession->ddp || ddpSession->syncMode || ddpSession->frameReady
+		|| ddpSession->numOfReceivedSegments == 0 || now - ddpSession->lastSegmentUs < DDP_FRAME_TIMEOUT_US)
+			continue;
+		session = ddpSession;
+		session->deltaRef.cur_uncached = true;
+		CommitSessionFrame();
+	}
+}
+
+// report the counters to the last sender, every telemetryIntervalMs
+void PollTelemetry(int sock)
+{
+	const uint64_t now = clocksync_now_us(CLOCK_MONOTONIC);
+	if(!telemetryHasPeer || now - lastTelemetryUs < (uint64_t)telemetryIntervalMs * 1000)
+		return;
+	lastTelemetryUs = now;
+
+	LedBurnTelemetry telemetry;
+	memcpy(telemetry.magic, "LBTelem", sizeof(telemetry.magic));
+	telemetry.version = LB_TELEMETRY_VERSION;
+	telemetry.seq = telemetrySeq++;
+	telemetry.lastFrameId = session ? session->currentFrame : 0;
+	telemetry.framesDisplayed = sentFrames;
+	telemetry.counters = counters;
+	// the kernel counts the datagrams its filter dropped along with the ones it had no room for
+	const uint32_t filtered = FilteredPackets();
+	telemetry.counters.invalidPackets += filtered;
+	telemetry.counters.rxQueueDrops -= min(filtered, telemetry.counters.rxQueueDrops);
+	telemetry.pruFrameUs = pruFrameUs;
+	telemetry.pruWaitUs = pruWaitUs;
+	pruWaitUs = 0;
+
+	if(sendto(sock, &telemetry, sizeof(telemetry), 0, (const struct sockaddr *) &telemetryPeer, sizeof(telemetryPeer)) < 0)
+		warn_once("[udp] sending telemetry failed: %s\n", strerror(errno));
+}
+
+// the kernel reports the datagrams it dropped on the socket so far, when it dropped any, when the datagram
+// arrived, and the size of the datagrams it coalesced into this read, when it did. returns that size, or 0
+int ReadControlMessages(struct msghdr *msg)
+{
+	int segmentSize = 0;
+	for(struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+		if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL)
+			memcpy(&counters.rxQueueDrops, CMSG_DATA(cmsg), sizeof(counters.rxQueueDrops));
+		else if(cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO)
+			memcpy(&segmentSize, CMSG_DATA(cmsg), sizeof(segmentSize));
+		else if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+			struct timespec ts;
+			memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+			packetRxUs = (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+		}
+	}
+	return segmentSize;
+}
+
+// a datagram of the LedBurn port: a clock sync reply, or LedBurn
+void HandleLedBurnDatagram(const uint8_t buf[], int len)
+{
+	if(clockMaster != NULL && clocksync_is_packet(buf, len, CLOCKSYNC_REPLY)) {
+		HandleClockSyncReply(buf);
+		return;
+	}
+	metrics_add(packetsMetric, 1);
+	metrics_add(bytesMetric, len);
+	HandleLedBurnPacket(buf, len);
+}
+
+void HandleXdpPacket(const uint8_t buf[], int len, const struct sockaddr_in6 *from)
+{
+	packetFrom = *from;
+	HandleLedBurnDatagram(buf, len);
+}
+
+// steer the LedBurn datagrams to the interface's IPv4 addresses, and to an IPv4 multicast group, past the
+// stack. the udp socket stays for the rest: IPv6, fragments, other queues, telemetry and clock sync
+void OpenXdpSocket()
+{
+	char name[IF_NAMESIZE + 8];
+	snprintf(name, sizeof(name), "%s", xdpInterface);
+	unsigned queue = 0;
+	char *colon = strchr(name, ':');
+	if(colon != NULL) {
+		*colon = '\0';
+		char *endPtr;
+		long q = strtol(colon + 1, &endPtr, 10);
+		if(endPtr == colon + 1 || *endPtr != '\0' || q < 0 || q > 255)
+			die("[xdp] queue should be between [0, 255]. received: '%s'\n", colon + 1);
+		queue = q;
+	}
+
+	struct in_addr addrs[XSK_MAX_ADDRS];
+	unsigned numAddrs = 0;
+	struct ifaddrs *ifaddrs;
+	if(getifaddrs(&ifaddrs) == 0) {
+		for(struct ifaddrs *ifa = ifaddrs; ifa != NULL; ifa = ifa->ifa_next) {
+			if(ifa->ifa_addr != NULL && ifa->ifa_addr->sa_family == AF_INET && strcmp(ifa->ifa_name, name) == 0 && numAddrs < XSK_MAX_ADDRS)
+				addrs[numAddrs++] = ((const struct sockaddr_in *) ifa->ifa_addr)->sin_addr;
+		}
+		freeifaddrs(ifaddrs);
+	}
+	if(multicastGroup != NULL && numAddrs < XSK_MAX_ADDRS && inet_pton(AF_INET, multicastGroup, &addrs[numAddrs]) == 1)
+		numAddrs++;
+	if(numAddrs == 0) {
+		fprintf(stderr, "[xdp] %s has no IPv4 address, LedBurn stays on the udp socket\n", name);
+		return;
+	}
+
+	xdpSocket = xsk_open(name, queue, 2000, addrs, numAddrs, xdpMode);
+	if(xdpSocket == NULL) {
+		fprintf(stderr, "[xdp] AF_XDP not available on %s, LedBurn stays on the udp socket\n", name);
+		return;
+	}
+	printf("[xdp] LedBurn datagrams on %s queue %u are received with AF_XDP, %s mode, %s\n", name, queue,
+		xdpSocket->generic ? "generic" : "native", xdpSocket->zero_copy ? "zero copy" : "copy");
+}
+
+// a run of datagrams from one sender the kernel coalesced. all are segmentSize long, but the last may be shorter
+void HandleCoalescedPackets(const uint8_t buf[], int len, int segmentSize)
+{
+	groReceives++;
+	for(int off = 0; off < len; off += segmentSize) {
+		HandleLedBurnDatagram(buf + off, min(segmentSize, len - off));
+		groSegments++;
+	}
+}
+
+// datagrams the kernel filter drops, by reason. counted in its map
+typedef enum
+{
+  LB_FILTER_MAGIC = 0, // neither LedBurn nor clock sync
+  LB_FILTER_HEADER, // unknown version, payload type, encoding or flags, or a truncated header
+  LB_FILTER_SEGMENT, // segment id or count, or pixel id, out of range
+  LB_FILTER_LENGTH, // payload length doesn't match the header
+  LB_FILTER_NUM_REASONS
+} LedBurnFilterReason;
+
+enum
+{
+  LF_ACCEPT, LF_CLOCK, LF_V1, LF_SYNC, LF_SEGMENTS, LF_COUNT, LF_DROP,
+  LF_REJECT_MAGIC, LF_REJECT_HEADER, LF_REJECT_SEGMENT, LF_REJECT_LENGTH
+};
+
+#define LF_PAYLOAD(off) (SOCKBPF_UDP_PAYLOAD + (off))
+
+// r0 = the little endian 16 bit field at off. r1 and the stack at -8 are scratch
+void FilterLoadLe16(sockbpf_prog_t *prog, int off)
+{
+	sockbpf_emit(prog, SOCKBPF_LD_ABS(BPF_B, LF_PAYLOAD(off + 1)));
+	sockbpf_emit(prog, SOCKBPF_ALU64_IMM(BPF_LSH, BPF_REG_0, 8));
+	sockbpf_emit(prog, SOCKBPF_STX_MEM(BPF_DW, BPF_REG_10, BPF_REG_0, -8));
+	sockbpf_emit(prog, SOCKBPF_LD_ABS(BPF_B, LF_PAYLOAD(off)));
+	sockbpf_emit(prog, SOCKBPF_LDX_MEM(BPF_DW, BPF_REG_1, BPF_REG_10, -8));
+	sockbpf_emit(prog, SOCKBPF_ALU64_REG(BPF_OR, BPF_REG_0, BPF_REG_1));
+}
+
+// r0 = the little endian 32 bit field at off, which must fit 16 bits
+void FilterLoadLe32(sockbpf_prog_t *prog, int off, unsigned reject)
+{
+	sockbpf_emit(prog, SOCKBPF_LD_ABS(BPF_H, LF_PAYLOAD(off + 2)));
+	sockbpf_jump_imm(prog, BPF_JNE, BPF_REG_0, 0, reject);
+	FilterLoadLe16(prog, off);
+}
+
+// jump to label if the register is below imm. the original eBPF jumps only have greater or equal
+void FilterJumpIfBelow(sockbpf_prog_t *prog, uint8_t reg, int32_t imm, unsigned label)
+{
+	sockbpf_emit(prog, SOCKBPF_INSN(BPF_JMP | BPF_JGE | BPF_K, reg, 0, 1, imm));
+	sockbpf_jump_imm(prog, BPF_JA, 0, 0, label);
+}
+
+// r1 = bytes of a pixel group of the payload type in r9
+void FilterGroupBytes(sockbpf_prog_t *prog)
+{
+	sockbpf_emit(prog, SOCKBPF_MOV64_IMM(BPF_REG_1, lbPixelGroup[0].bytes));
+	for(int t=1; t<LB_NUM_OF_PAYLOAD_TYPES; t++) {
+		sockbpf_emit(prog, SOCKBPF_INSN(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_9, 0, 1, t));
+		sockbpf_emit(prog, SOCKBPF_MOV64_IMM(BPF_REG_1, lbPixelGroup[t].bytes));
+	}
+}
+
+// drop malformed datagrams in the kernel, before they are copied to us. it checks what VerifyLedBurnPacket
+// and BeforePaintLeds can tell from the header, except strip ids: segments for strips that are not ours
+// still count towards the frame. clock sync replies share the socket, and pass.
+// the filter sees a coalesced run of datagrams as one, with the first header and the length of all,
+// so with UDP_GRO it can't check payload lengths, and leaves them to the server
+bool AttachLedBurnFilter(int sock, bool checkLength)
+{
+	if(!sockbpf_init(&ledBurnFilter, LB_FILTER_NUM_REASONS))
+		return false;
+	sockbpf_prog_t *prog = &ledBurnFilter;
+
+	// r6 = skb, r7 = header size then the drop reason, r8 = datagram length with the udp header, r9 = payload type
+	sockbpf_emit(prog, SOCKBPF_MOV64_REG(BPF_REG_6, BPF_REG_1));
+	sockbpf_emit(prog, SOCKBPF_LDX_MEM(BPF_W, BPF_REG_8, BPF_REG_6, offsetof(struct __sk_buff, len)));
+	FilterJumpIfBelow(prog, BPF_REG_8, LF_PAYLOAD(LB_HEADER_SIZE), LF_REJECT_HEADER);
+
+	sockbpf_emit(prog, SOCKBPF_LD_ABS(BPF_W, LF_PAYLOAD(0)));
+	sockbpf_jump_imm(prog, BPF_JNE, BPF_REG_0, 0x4c656442, LF_CLOCK); // "LedB"
+	sockbpf_emit(prog, SOCKBPF_LD_ABS(BPF_H, LF_PAYLOAD(4)));
+	sockbpf_jump_imm(prog, BPF_JNE, BPF_REG_0, 0x7572, LF_REJECT_MAGIC); // "ur"
+	sockbpf_emit(prog, SOCKBPF_LD_ABS(BPF_B, LF_PAYLOAD(6)));
+	sockbpf_jump_imm(prog, BPF_JNE, BPF_REG_0, 'n', LF_REJECT_MAGIC);
+
+	sockbpf_emit(prog, SOCKBPF_LD_ABS(BPF_B, LF_PAYLOAD(7)));
+	sockbpf_emit(prog, SOCKBPF_MOV64_REG(BPF_REG_9, BPF_REG_0));
+	sockbpf_emit(prog, SOCKBPF_ALU64_IMM(BPF_RSH, BPF_REG_9, 4));
+	sockbpf_jump_imm(prog, BPF_JGE, BPF_REG_9, LB_NUM_OF_PAYLOAD_TYPES, LF_REJECT_HEADER);
+	sockbpf_emit(prog, SOCKBPF_ALU64_IMM(BPF_AND, BPF_REG_0, 0x0F));
+	sockbpf_jump_imm(prog, BPF_JEQ, BPF_REG_0, 1, LF_V1);
+	sockbpf_jump_imm(prog, BPF_JNE, BPF_REG_0, 0, LF_REJECT_HEADER);
+
+	// version 0: no palettes, and the payload is whole pixel groups
+	sockbpf_jump_imm(prog, BPF_JGE, BPF_REG_9, LB_PAYLOAD_PALETTE8, LF_REJECT_HEADER);
+	if(checkLength) {
+		FilterGroupBytes(prog);
+		sockbpf_emit(prog, SOCKBPF_MOV64_REG(BPF_REG_0, BPF_REG_8));
+		sockbpf_emit(prog, SOCKBPF_ALU64_IMM(BPF_SUB, BPF_REG_0, LF_PAYLOAD(LB_HEADER_SIZE)));
+		sockbpf_emit(prog, SOCKBPF_ALU64_REG(BPF_MOD, BPF_REG_0, BPF_REG_1));
+		sockbpf_jump_imm(prog, BPF_JNE, BPF_REG_0, 0, LF_REJECT_LENGTH);
+	}
+	sockbpf_jump_imm(prog, BPF_JA, 0, 0, LF_SEGMENTS);
+
+	// version 1: encoding and flags at -16 and -24, number of pixels at -32
+	sockbpf_label(prog, LF_V1);
+	FilterJumpIfBelow(prog, BPF_REG_8, LF_PAYLOAD(LB_V1_HEADER_SIZE), LF_REJECT_HEADER);
+	sockbpf_emit(prog, SOCKBPF_LD_ABS(BPF_B, LF_PAYLOAD(24)));
+	sockbpf_jump_imm(prog, BPF_JGE, BPF_REG_0, LB_NUM_OF_ENCODINGS, LF_REJECT_HEADER);
+	sockbpf_emit(prog, SOCKBPF_STX_MEM(BPF_DW, BPF_REG_10, BPF_REG_0, -16));
+	sockbpf_emit(prog, SOCKBPF_LD_ABS(BPF_B, LF_PAYLOAD(25)));
+	sockbpf_jump_imm(prog, BPF_JSET, BPF_REG_0, ~LB_KNOWN_FLAGS & 0xFF, LF_REJECT_HEADER);
+	sockbpf_emit(prog, SOCKBPF_STX_MEM(BPF_DW, BPF_REG_10, BPF_REG_0, -24));
+	sockbpf_emit(prog, SOCKBPF_MOV64_IMM(BPF_REG_7, LF_PAYLOAD(LB_V1_HEADER_SIZE)));
+	sockbpf_emit(prog, SOCKBPF_INSN(BPF_JMP | BPF_JSET | BPF_K, BPF_REG_0, 0, 1, LB_FLAG_PRESENTATION_TIME));
+	sockbpf_emit(prog, SOCKBPF_INSN(BPF_JMP | BPF_JA, 0, 0, 1, 0));
+	sockbpf_emit(prog, SOCKBPF_ALU64_IMM(BPF_ADD, BPF_REG_7, LB_PRESENTATION_TIME_SIZE));
+	sockbpf_jump_reg(prog, BPF_JGT, BPF_REG_7, BPF_REG_8, LF_REJECT_HEADER);
+	sockbpf_jump_imm(prog, BPF_JSET, BPF_REG_0, LB_FLAG_SYNC, LF_SYNC);
+	FilterLoadLe16(prog, 26);
+	sockbpf_jump_imm(prog, BPF_JEQ, BPF_REG_0, 0, LF_REJECT_HEADER);
+	sockbpf_emit(prog, SOCKBPF_STX_MEM(BPF_DW, BPF_REG_10, BPF_REG_0, -32));
+
+	// raw payloads are as long as their pixels. the rest are checked once decoded
+	if(checkLength) {
+		sockbpf_emit(prog, SOCKBPF_LDX_MEM(BPF_DW, BPF_REG_0, BPF_REG_10, -16));
+		sockbpf_jump_imm(prog, BPF_JNE, BPF_REG_0, LB_ENCODING_RAW, LF_SEGMENTS);
+		sockbpf_emit(prog, SOCKBPF_LDX_MEM(BPF_DW, BPF_REG_0, BPF_REG_10, -24));
+		sockbpf_jump_imm(prog, BPF_JSET, BPF_REG_0, LB_FLAG_LZ4 | LB_FLAG_PIXEL_MAJOR | LB_FLAG_PARITY, LF_SEGMENTS);
+		sockbpf_jump_imm(prog, BPF_JGE, BPF_REG_9, LB_PAYLOAD_PALETTE8, LF_SEGMENTS);
+		sockbpf_emit(prog, SOCKBPF_LDX_MEM(BPF_DW, BPF_REG_0, BPF_REG_10, -32));
+		sockbpf_emit(prog, SOCKBPF_INSN(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_9, 0, 2, LB_PAYLOAD_RGB12));
+		sockbpf_emit(prog, SOCKBPF_ALU64_IMM(BPF_ADD, BPF_REG_0, 1));
+		sockbpf_emit(prog, SOCKBPF_ALU64_IMM(BPF_RSH, BPF_REG_0, 1));
+		FilterGroupBytes(prog);
+		sockbpf_emit(prog, SOCKBPF_ALU64_REG(BPF_MUL, BPF_REG_0, BPF_REG_1));
+		sockbpf_emit(prog, SOCKBPF_MOV64_REG(BPF_REG_1, BPF_REG_8));
+		sockbpf_emit(prog, SOCKBPF_ALU64_REG(BPF_SUB, BPF_REG_1, BPF_REG_7));
+		sockbpf_jump_reg(prog, BPF_JNE, BPF_REG_0, BPF_REG_1, LF_REJECT_LENGTH);
+	}
+	sockbpf_jump_imm(prog, BPF_JA, 0, 0, LF_SEGMENTS);
+
+	// sync packets are just the header, and their segment fields are ignored
+	sockbpf_label(prog, LF_SYNC);
+	if(checkLength)
+		sockbpf_jump_reg(prog, BPF_JNE, BPF_REG_7, BPF_REG_8, LF_REJECT_LENGTH);
+	sockbpf_jump_imm(prog, BPF_JA, 0, 0, LF_ACCEPT);
+
+	// as BeforePaintLeds: 0 < segInFrame < MAX_SUPPORTED_SEGMENTS, currSegId < segInFrame, pixelId < MAX_SUPPORTED_PIXELS_PER_STRAND
+	sockbpf_label(prog, LF_SEGMENTS);
+	FilterLoadLe32(prog, 12, LF_REJECT_SEGMENT);
+	sockbpf_jump_imm(prog, BPF_JEQ, BPF_REG_0, 0, LF_REJECT_SEGMENT);
+	sockbpf_jump_imm(prog, BPF_JGE, BPF_REG_0, MAX_SUPPORTED_SEGMENTS, LF_REJECT_SEGMENT);
+	sockbpf_emit(prog, SOCKBPF_STX_MEM(BPF_DW, BPF_REG_10, BPF_REG_0, -16));
+	FilterLoadLe32(prog, 16, LF_REJECT_SEGMENT);
+	sockbpf_emit(prog, SOCKBPF_LDX_MEM(BPF_DW, BPF_REG_1, BPF_REG_10, -16));
+	sockbpf_jump_reg(prog, BPF_JGE, BPF_REG_0, BPF_REG_1, LF_REJECT_SEGMENT);
+	FilterLoadLe16(prog, 22);
+	sockbpf_jump_imm(prog, BPF_JGE, BPF_REG_0, MAX_SUPPORTED_PIXELS_PER_STRAND, LF_REJECT_SEGMENT);
+
+	sockbpf_label(prog, LF_ACCEPT);
+	sockbpf_emit(prog, SOCKBPF_MOV32_IMM(BPF_REG_0, -1)); // the whole datagram
+	sockbpf_emit(prog, SOCKBPF_EXIT());
+
+	sockbpf_label(prog, LF_CLOCK);
+	sockbpf_jump_imm(prog, BPF_JNE, BPF_REG_0, 0x4c42436c, LF_REJECT_MAGIC); // "LBCl"
+	sockbpf_emit(prog, SOCKBPF_LD_ABS(BPF_H, LF_PAYLOAD(4)));
+	sockbpf_jump_imm(prog, BPF_JNE, BPF_REG_0, 0x6f63, LF_REJECT_MAGIC); // "oc"
+	sockbpf_emit(prog, SOCKBPF_LD_ABS(BPF_B, LF_PAYLOAD(6)));
+	sockbpf_jump_imm(prog, BPF_JNE, BPF_REG_0, 'k', LF_REJECT_MAGIC);
+	sockbpf_jump_imm(prog, BPF_JA, 0, 0, LF_ACCEPT);
+
+	const unsigned rejects[LB_FILTER_NUM_REASONS] = { LF_REJECT_MAGIC, LF_REJECT_HEADER, LF_REJECT_SEGMENT, LF_REJECT_LENGTH };
+	for(int r=0; r<LB_FILTER_NUM_REASONS; r++) {
+		if(r == LB_FILTER_LENGTH && !checkLength)
+			continue; // the verifier refuses unreachable code
+		sockbpf_label(prog, rejects[r]);
+		sockbpf_emit(prog, SOCKBPF_MOV64_IMM(BPF_REG_7, r));
+		sockbpf_jump_imm(prog, BPF_JA, 0, 0, LF_COUNT);
+	}
+
+	// count the drop reason in the map, and drop
+	sockbpf_label(prog, LF_COUNT);
+	sockbpf_emit(prog, SOCKBPF_STX_MEM(BPF_W, BPF_REG_10, BPF_REG_7, -4));
+	sockbpf_load_map(prog, BPF_REG_1);
+	sockbpf_emit(prog, SOCKBPF_MOV64_REG(BPF_REG_2, BPF_REG_10));
+	sockbpf_emit(prog, SOCKBPF_ALU64_IMM(BPF_ADD, BPF_REG_2, -4));
+	sockbpf_emit(prog, SOCKBPF_CALL(BPF_FUNC_map_lookup_elem));
+	sockbpf_jump_imm(prog, BPF_JEQ, BPF_REG_0, 0, LF_DROP);
+	sockbpf_emit(prog, SOCKBPF_MOV64_IMM(BPF_REG_1, 1));
+	sockbpf_emit(prog, SOCKBPF_ATOMIC_ADD64(BPF_REG_0, BPF_REG_1, 0));
+	sockbpf_label(prog, LF_DROP);
+	sockbpf_emit(prog, SOCKBPF_MOV64_IMM(BPF_REG_0, 0));
+	sockbpf_emit(prog, SOCKBPF_EXIT());
+
+	return sockbpf_attach(prog, sock);
+}
+
+// datagrams the kernel filter dropped so far
+uint32_t FilteredPackets()
+{
+	uint64_t dropped = 0;
+	if(ledBurnFilterAttached) {
+		for(int r=0; r<LB_FILTER_NUM_REASONS; r++)
+			dropped += sockbpf_counter(&ledBurnFilter, r);
+	}
+	return dropped;
+}
+
+void PrintFilterStats()
+{
+	printf("info: kernel filter dropped %" PRIu64 " bad magic, %" PRIu64 " bad header, %" PRIu64 " out of range, %" PRIu64 " bad length\n",
+		sockbpf_counter(&ledBurnFilter, LB_FILTER_MAGIC), sockbpf_counter(&ledBurnFilter, LB_FILTER_HEADER),
+		sockbpf_counter(&ledBurnFilter, LB_FILTER_SEGMENT), sockbpf_counter(&ledBurnFilter, LB_FILTER_LENGTH));
+}
+
+// read by the metrics endpoint's thread
+uint64_t FilteredPacketsMetric()
+{
+	return FilteredPackets();
+}
+
+uint64_t RxQueueDropsMetric()
+{
+	// the kernel counts the datagrams its filter dropped along with the ones it had no room for
+	const uint32_t drops = __atomic_load_n(&counters.rxQueueDrops, __ATOMIC_RELAXED);
+	const uint32_t filtered = FilteredPackets();
+	return drops - min(filtered, drops);
+}
+
+void InitMetrics()
+{
+	packetsMetric = metrics_register("ledburn_packets_total", METRICS_COUNTER, "LedBurn datagrams received");
+	bytesMetric = metrics_register("ledburn_bytes_total", METRICS_COUNTER, "bytes of the LedBurn datagrams received");
+	metrics_register_u32("ledburn_segments_total", METRICS_COUNTER, "segments received, of any protocol", &counters.segments);
+	metrics_register_u32("ledburn_invalid_packets_total", METRICS_COUNTER, "malformed datagrams the server dropped", &counters.invalidPackets);
+	metrics_register_fn("ledburn_filtered_packets_total", METRICS_COUNTER, "malformed datagrams the kernel filter dropped", FilteredPacketsMetric);
+	metrics_register_u32("ledburn_duplicate_segments_total", METRICS_COUNTER, "segments received twice", &counters.duplicateSegments);
+	metrics_register_u32("ledburn_late_segments_total", METRICS_COUNTER, "segments of frames older than the current one", &counters.lateSegments);
+	metrics_register_u32("ledburn_decode_failures_total", METRICS_COUNTER, "segments that failed to decode", &counters.decodeFailures);
+	metrics_register_fn("ledburn_rx_queue_drops_total", METRICS_COUNTER, "datagrams dropped with the socket buffer full", RxQueueDropsMetric);
+	referenceResetsMetric = metrics_register("ledburn_reference_resets_total", METRICS_COUNTER, "times a sender's frame ids jumped, and were taken as the new reference");
+	metrics_register_u32("ledburn_partial_frames_total", METRICS_COUNTER, "frames sent with segments missing", &counters.partialFrames);
+	framesMetric = metrics_register("ledburn_frames_total", METRICS_COUNTER, "frames sent to the PRU");
+	pruBusyMetric = metrics_register("ledburn_pru_busy_microseconds_total", METRICS_COUNTER, "time the PRU spent sending frames");
+	pruWaitMetric = metrics_register("ledburn_pru_wait_microseconds_total", METRICS_COUNTER, "time spent in ledscape_wait for the PRU to finish a frame");
+	metrics_register_u32("ledburn_pru_frame_microseconds", METRICS_GAUGE, "time the PRU took to send the last frame", &pruFrameUs);
+}
+
+void MainLoop()
+{
+	printf("Initialize udp listen socket\n");
+	
+	const int sock = socket(AF_INET6, SOCK_DGRAM, 0);
+	if (sock < 0) {
+		die("[udp] socket failed: %s\n", strerror(errno));
+	}
+
+	// set the socket to non bloking.
+	int flags = fcntl(sock,F_GETFL);
+	flags |= O_NONBLOCK;
+	fcntl(sock, F_SETFL, flags);
+
+
+	struct sockaddr_in6 addr;
+	bzero(&addr, sizeof(addr));
+	addr.sin6_family = AF_INET6;
+	addr.sin6_addr = in6addr_any;
+	addr.sin6_port = htons(2000);
+
+	if (bind(sock, (const struct sockaddr*) &addr, sizeof(addr)) < 0)
+	{
+		die("[udp] bind port %d failed: %s\n", 2000, strerror(errno));
+	}
+
+	if(multicastGroup != NULL) {
+		JoinMulticastGroup(sock, multicastGroup);
+		printf("[udp] joined multicast group %s%s%s\n", multicastGroup,
+			multicastInterface ? " on " : "", multicastInterface ? multicastInterface : "");
+	}
+	if(clockMaster != NULL)
+		ResolveClockMaster();
+
+	ledBurnFilterAttached = AttachLedBurnFilter(sock, !groEnabled);
+	if(ledBurnFilterAttached)
+		printf("[udp] kernel filter attached, malformed datagrams are dropped before they are read\n");
+	else
+		fprintf(stderr, "[udp] kernel filter not attached, malformed datagrams are checked after they are read\n");
+
+	const int one = 1;
+	if(setsockopt(sock, SOL_SOCKET, SO_RXQ_OVFL, &one, sizeof(one)) < 0)
+		fprintf(stderr, "[udp] SO_RXQ_OVFL failed, queue drops won't be reported: %s\n", strerror(errno));
+	if(setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPNS, &one, sizeof(one)) < 0)
+		fprintf(stderr, "[udp] SO_TIMESTAMPNS failed, segments are timed as they are read: %s\n", strerror(errno));
+	if(groEnabled) {
+		if(setsockopt(sock, SOL_UDP, UDP_GRO, &one, sizeof(one)) < 0)
+			die("[udp] UDP_GRO failed, the kernel can't coalesce datagrams (linux 5.0 or later): %s\n", strerror(errno));
+		printf("[udp] receive coalescing (UDP_GRO) enabled\n");
+	}
+	if(xdpInterface != NULL)
+		OpenXdpSocket();
+	if(metricsEndpoint != NULL && metrics_serve(metricsEndpoint))
+		printf("[metrics] serving metrics on %s\n", metricsEndpoint);
+
+	const int artnetSock = artnetMap != NULL ? OpenReceiverSocket("artnet", ARTNET_PORT, artnetMap) : -1;
+	if(e131Map != NULL) {
+		e131Sock = OpenReceiverSocket("e131", E131_PORT, e131Map);
+		for(unsigned u=0; u<e131Map->num_universes; u++) {
+			if(e131Map->ranges[u].num_pixels != 0)
+				JoinE131Universe(e131Map->first_universe + u);
+		}
+		printf("[e131] joined the multicast groups of the universes%s%s\n",
+			multicastInterface ? " on " : "", multicastInterface ? multicastInterface : "");
+	}
+	const int opcListenSock = opcPort ? OpenOpcListenSocket() : -1;
+	const int ddpSock = ddpEnabled ? OpenReceiverSocket("ddp", DDP_PORT, NULL) : -1;
+	const int opcUdpSock = opcPort ? OpenReceiverSocket("opc", opcPort, NULL) : -1;
+
+	uint8_t buf[65536];
+	uint8_t control[CMSG_SPACE(sizeof(uint32_t)) + CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(struct timespec))];
+	struct iovec iov = { .iov_base = buf, .iov_len = sizeof(buf) };
+	struct msghdr msg;
+	printf("Done initializing udp listen socket\n");	
+	
+	
+	printf("Starting main loop\n");
+
+	for(;;) {
+		if(artnetSock >= 0)
+			PollReceiver(artnetSock, HandleArtNetPacket);
+		if(e131Sock >= 0)
+			PollReceiver(e131Sock, HandleE131Packet);
+		if(opcListenSock >= 0)
+			PollOpc(opcListenSock, opcUdpSock);
+		if(ddpSock >= 0)
+			PollReceiver(ddpSock, HandleDdpPacket);
+		if(xdpSocket != NULL)
+			xsk_poll(xdpSocket, HandleXdpPacket);
+
+		bzero(&msg, sizeof(msg));
+		msg.msg_name = &packetFrom;
+		msg.msg_namelen = sizeof(packetFrom);
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+		PROFILE_START(recvStart);
+		const ssize_t rc = recvmsg(sock, &msg, 0);
+		if(rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			PROFILE_POLL();
+			if(drawStartUs && !is_ledscape_busy(leds))
+				TrackPruFrameTime();
+			if(clockMaster != NULL)
+				PollClockSync(sock);
+			if(telemetryIntervalMs)
+				PollTelemetry(sock);
+			if(ddpSock >= 0)
+				CommitPausedDdpFrames();
+			FlushFrames();
+			ReplayHeldDatagrams();
+			continue;			
+		}
+		if (rc < 0) {
+			fprintf(stderr, "[udp] recv failed: %s\n", strerror(errno));
+			continue;
+		}
+		PROFILE_END(STAGE_RECV, recvStart); // of the reads that got a datagram
+		const int segmentSize = msg.msg_controllen > 0 ? ReadControlMessages(&msg) : 0;
+		if(segmentSize > 0 && rc > segmentSize)
+			HandleCoalescedPackets(buf, rc, segmentSize);
+		else
+			HandleLedBurnDatagram(buf, rc);
+		packetRxUs = 0; // the other receivers don't have timestamps
+	}
+
+	ledscape_close(leds);
+}
+
+void PlayInitSequence() {
+	SetAllSameColor(255, 0, 0);
+	usleep(1000 * 1000);
+	SetAllSameColor(0, 255, 0);
+	usleep(1000 * 1000);
+	SetAllSameColor(0, 0, 255);
+	usleep(1000 * 1000);
+	SetAllSameColor(0, 0, 0);
+}
+
+void SetNumberOfPixelsInStrand(const char *arg) {
+	if(arg != NULL) {
+		char *endPtr;
+		errno = 0; /* To distinguish success/failure after call */
+		long numberOfPixels = strtol(arg, &endPtr, 10);\
+		
+		// check non integer values
+		if(endPtr == arg || *endPtr != '\0') {
+			fprintf(stderr, "first parameter to the ledburn server should be number of pixels. received non integer value: '%s'\n", arg);
+			exit(EXIT_FAILURE);
+		}
+		
+		// check out of range
+		if ((errno == ERANGE && (numberOfPixels == LONG_MAX || numberOfPixels == LONG_MIN)) || (errno != 0 && numberOfPixels == 0)) {
+			fprintf(stderr, "first parameter to the ledburn server should be number of pixels. received invalid value: %s\n", arg);
+			exit(EXIT_FAILURE);
+		}
+		
+		// check if value is not reasonable
+
+		if(numberOfPixels > MAX_SUPPORTED_PIXELS_PER_STRAND || numberOfPixels <= 0) {
+			fprintf(stderr, "number of pixels from command line argument is not supported. value should be between [1, %d]. received: %ld\n", MAX_SUPPORTED_PIXELS_PER_STRAND, numberOfPixels);
+			exit(EXIT_FAILURE);			
+		}
+		
+		pixelsPerStrand = numberOfPixels;
+		printf("pixels per strand set from command line argument to = %d\n", pixelsPerStrand);
+	}
+	else {
+		printf("pixels per strand not set from command line argument. using default value %d\n", pixelsPerStrand);
+	}
+}
+
+static double ElapsedMicros(const struct timespec *start, const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) * 1e6 + (end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+// time the per frame work with a full frame, without touching the PRU,
+// and compare it with the 20ms budget of a 50Hz frame
+void RunBenchmark()
+{
+	const int iterations = 100;
+	const double frameBudgetMicros = 1e6 / 50;
+	struct timespec start, end;
+
+	printf("benchmark: %u strips x %d pixels, %d iterations\n", numStrips, pixelsPerStrand, iterations);
+
+	ledscape_frame_t *out = calloc(1, ledscape_frame_size(numStrips, pixelsPerStrand));
+	frame = calloc(1, ledscape_frame_size(numStrips, pixelsPerStrand));
+	// random payload bytes for all the benchmarks: a strip of the widest pixels, an Art-Net universe,
+	// or a full 8 bit palette, whichever is longer
+	const int payloadBytes = max(pixelsPerStrand * 6, PALETTE8_ENTRIES * 3);
+	uint8_t *packet = calloc(LB_HEADER_SIZE + payloadBytes, 1);
+	if(out == NULL || frame == NULL || packet == NULL)
+		die("benchmark: unable to allocate\n");
+	for(int i=LB_HEADER_SIZE; i<LB_HEADER_SIZE + payloadBytes; i++)
+		packet[i] = rand();
+
+	PacketHeaderData phd = { .pixelId = 0, .payloadType = LB_PAYLOAD_RGB, .flags = 0, .numOfPixels = pixelsPerStrand, .payload = packet + LB_HEADER_SIZE };
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int it=0; it<iterations; it++) {
+		for(phd.stripId=0; phd.stripId<numStrips; phd.stripId++)
+			PaintLeds(&phd);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double micros = ElapsedMicros(&start, &end) / iterations;
+	printf("benchmark: paint rgb          %8.1f us/frame (%5.1f%% of 50Hz budget)\n", micros, 100 * micros / frameBudgetMicros);
+
+	// pixel major segments that fit a 1400 byte datagram, with full rows and with rows of 8 strips
+	uint8_t *rows = calloc(1, ledscape_frame_size(numStrips, pixelsPerStrand));
+	if(rows == NULL)
+		die("benchmark: unable to allocate\n");
+	phd.flags = LB_FLAG_PIXEL_MAJOR;
+	phd.payload = rows;
+	const unsigned widths[2] = { numStrips, LEDSCAPE_STRIP_ALIGN };
+	for(int w=0; w<2 && (w == 0 || widths[w] != widths[0]); w++) {
+		const unsigned rowBytes = widths[w] * sizeof(ledscape_pixel_t);
+		const int rowsPerSegment = 1400 / rowBytes > 0 ? 1400 / rowBytes : 1;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for(int it=0; it<iterations; it++) {
+			for(phd.stripId=0; phd.stripId<numStrips; phd.stripId+=widths[w]) {
+				for(phd.pixelId=0; phd.pixelId<pixelsPerStrand; phd.pixelId+=rowsPerSegment) {
+					phd.numOfPixels = min(rowsPerSegment, pixelsPerStrand - phd.pixelId);
+					phd.payloadLength = phd.numOfPixels * rowBytes;
+					PaintLeds(&phd);
+				}
+			}
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		micros = ElapsedMicros(&start, &end) / iterations;
+		printf("benchmark: pixel major x%-2u    %8.1f us/frame (%5.1f%% of 50Hz budget)\n", widths[w], micros, 100 * micros / frameBudgetMicros);
+	}
+	free(rows);
+
+	// Art-Net, a datagram per universe: parse, look the universe up and paint it
+	universe_map_t *benchArtnet = universe_map_init(0, numStrips, pixelsPerStrand, UNIVERSE_MAX_PIXELS);
+	uint8_t (*dmx)[ARTNET_DMX_HEADER_SIZE + 512] = calloc(benchArtnet->num_universes, sizeof(*dmx));
+	if(dmx == NULL)
+		die("benchmark: unable to allocate\n");
+	for(unsigned u=0; u<benchArtnet->num_universes; u++) {
+		memcpy(dmx[u], "Art-Net\0\x00\x50\x00\x0e", 12);
+		dmx[u][14] = u & 0xFF;
+		dmx[u][15] = u >> 8;
+		dmx[u][16] = 510 >> 8;
+		dmx[u][17] = 510 & 0xFF;
+		memcpy(dmx[u] + ARTNET_DMX_HEADER_SIZE, packet + LB_HEADER_SIZE, 510);
+	}
+	phd.flags = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int it=0; it<iterations; it++) {
+		for(unsigned u=0; u<benchArtnet->num_universes; u++) {
+			artnet_packet_t artnet;
+			if(!artnet_parse(dmx[u], sizeof(dmx[u]), &artnet))
+				die("benchmark: bad Art-Net packet\n");
+			const universe_range_t *range = universe_map_lookup(benchArtnet, artnet.universe);
+			phd.stripId = range->strip;
+			phd.pixelId = range->pixel;
+			phd.numOfPixels = min(range->num_pixels, artnet.length / 3);
+			phd.payload = artnet.data;
+			PaintLeds(&phd);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	micros = ElapsedMicros(&start, &end) / iterations;
+	printf("benchmark: artnet %3u univ.   %8.1f us/frame (%5.1f%% of 50Hz budget)\n", benchArtnet->num_universes, micros, 100 * micros / frameBudgetMicros);
+
+	// E1.31, with two sources of the same priority in every universe: merge HTP, then paint
+	e131_merge_t *benchMerge = e131_merge_init(benchArtnet->num_universes, E131_MERGE_HTP);
+	const uint8_t cids[2][E131_CID_SIZE] = { { 1 }, { 2 } };
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int it=0; it<iterations; it++) {
+		for(unsigned u=0; u<benchArtnet->num_universes; u++) {
+			for(int c=0; c<2; c++) {
+				const e131_packet_t e131 = { .type = E131_DATA, .cid = cids[c], .priority = 100, .universe = u + 1,
+					.data = dmx[(u + c) % benchArtnet->num_universes] + ARTNET_DMX_HEADER_SIZE, .length = 510 };
+				const universe_range_t *range = &benchArtnet->ranges[u];
+				uint16_t length;
+				bool lead;
+				phd.payload = e131_merge(benchMerge, range->segment, &e131, it, &length, &lead);
+				phd.stripId = range->strip;
+				phd.pixelId = range->pixel;
+				phd.numOfPixels = min(range->num_pixels, length / 3);
+				PaintLeds(&phd);
+			}
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	micros = ElapsedMicros(&start, &end) / iterations;
+	printf("benchmark: e131 htp x2        %8.1f us/frame (%5.1f%% of 50Hz budget)\n", micros, 100 * micros / frameBudgetMicros);
+	e131_merge_close(benchMerge);
+	free(dmx);
+	universe_map_close(benchArtnet);
+
+	// delta decode, with one pixel in ten changing from frame to frame
+	const size_t stripBytes = pixelsPerStrand * 3;
+	delta_t *benchDelta = delta_init(numStrips, stripBytes);
+	uint8_t *encoded = malloc(numStrips * stripBytes * 2);
+	size_t *encodedLength = calloc(numStrips, sizeof(size_t));
+	uint8_t *changed = malloc(stripBytes);
+	if(encoded == NULL || encodedLength == NULL || changed == NULL)
+		die("benchmark: unable to allocate\n");
+	size_t wireBytes = 0;
+	for(unsigned s=0; s<numStrips; s++) {
+		memcpy((uint8_t *)delta_ref_strip(benchDelta, s), packet + LB_HEADER_SIZE, stripBytes);
+		memcpy(changed, packet + LB_HEADER_SIZE, stripBytes);
+		for(int i=rand() % 10; i<pixelsPerStrand; i += 10)
+			changed[i * 3 + rand() % 3] ^= 1 + rand() % 255;
+		encodedLength[s] = delta_encode_xor_rle(changed, delta_ref_strip(benchDelta, s), stripBytes, encoded + s * stripBytes * 2);
+		wireBytes += encodedLength[s];
+	}
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int it=0; it<iterations; it++) {
+		for(unsigned s=0; s<numStrips; s++)
+			delta_decode_xor_rle(encoded + s * stripBytes * 2, encodedLength[s], delta_ref_strip(benchDelta, s), delta_cur_strip(benchDelta, s), stripBytes);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	micros = ElapsedMicros(&start, &end) / iterations;
+	printf("benchmark: delta decode       %8.1f us/frame (%5.1f%% of 50Hz budget), %zu of %zu bytes on the wire\n",
+		micros, 100 * micros / frameBudgetMicros, wireBytes, numStrips * stripBytes);
+	free(changed);
+	free(encodedLength);
+	free(encoded);
+	delta_close(benchDelta);
+
+	// lz4 decompress, of a strip wide gradient
+	uint8_t *gradient = malloc(stripBytes);
+	uint8_t *compressed = malloc(LZ4_BLOCK_BOUND(stripBytes));
+	if(gradient == NULL || compressed == NULL)
+		die("benchmark: unable to allocate\n");
+	for(size_t i=0; i<stripBytes; i++)
+		gradient[i] = (i / 3) * 256 / pixelsPerStrand;
+	const size_t compressedLength = lz4_block_compress(gradient, stripBytes, compressed);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int it=0; it<iterations; it++) {
+		for(unsigned s=0; s<numStrips; s++)
+			lz4_block_decompress(compressed, compressedLength, lz4Scratch, sizeof(lz4Scratch));
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	micros = ElapsedMicros(&start, &end) / iterations;
+	printf("benchmark: lz4 decompress     %8.1f us/frame (%5.1f%% of 50Hz budget), gradient ratio %.2f\n",
+		micros, 100 * micros / frameBudgetMicros, (double) stripBytes / compressedLength);
+	free(compressed);
+	free(gradient);
+
+	// fec, one segment per strip in groups of 8 with one lost per group
+	const size_t datagramLength = LB_V1_HEADER_SIZE + stripBytes;
+	const unsigned fecK = 8;
+	uint8_t *datagrams = malloc(numStrips * datagramLength);
+	const uint8_t **groupDatagrams = calloc(fecK, sizeof(*groupDatagrams));
+	size_t *groupLengths = calloc(fecK, sizeof(*groupLengths));
+	uint8_t *parity = malloc(datagramLength);
+	if(datagrams == NULL || groupDatagrams == NULL || groupLengths == NULL || parity == NULL)
+		die("benchmark: unable to allocate\n");
+	for(size_t i=0; i<numStrips * datagramLength; i++)
+		datagrams[i] = rand();
+	fec_t *benchFec = fec_init(numStrips, FEC_ARENA_SIZE);
+	bool fecMismatch = false;
+	double fecMicros = 0;
+	for(int it=0; it<iterations; it++) {
+		for(unsigned first=0; first<numStrips; first+=fecK) {
+			for(unsigned i=0; i<fecK; i++) {
+				groupDatagrams[i] = datagrams + (first + i) * datagramLength;
+				groupLengths[i] = datagramLength;
+				if(i != it % fecK)
+					fec_add_data(benchFec, first + i, groupDatagrams[i], datagramLength);
+			}
+			fec_add_parity(benchFec, first, fecK, parity, fec_parity(groupDatagrams, groupLengths, fecK, parity));
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			const size_t len = fec_recover(benchFec, first, fecRecovered);
+			clock_gettime(CLOCK_MONOTONIC, &end);
+			fecMicros += ElapsedMicros(&start, &end);
+			if(len != datagramLength || memcmp(fecRecovered + 7, groupDatagrams[it % fecK] + 7, datagramLength - 7) != 0)
+				fecMismatch = true;
+		}
+		fec_end_frame(benchFec);
+	}
+	micros = fecMicros / iterations;
+	printf("benchmark: fec recover 1/%u    %8.1f us/frame (%5.1f%% of 50Hz budget)%s\n", fecK, micros, 100 * micros / frameBudgetMicros,
+		fecMismatch ? ", MISMATCH" : "");
+	fec_close(benchFec);
+	free(parity);
+	free(groupLengths);
+	free(groupDatagrams);
+	free(datagrams);
+
+	// palette expansion, with the random packet as palette and indices
+	uint8_t *expanded = malloc(stripBytes);
+	if(expanded == NULL)
+		die("benchmark: unable to allocate\n");
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int it=0; it<iterations; it++) {
+		for(unsigned s=0; s<numStrips; s++)
+			palette_expand8(packet + LB_HEADER_SIZE, packet + LB_HEADER_SIZE + s, expanded, pixelsPerStrand);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	micros = ElapsedMicros(&start, &end) / iterations;
+	printf("benchmark: palette 8 bit      %8.1f us/frame (%5.1f%% of 50Hz budget)\n", micros, 100 * micros / frameBudgetMicros);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int it=0; it<iterations; it++) {
+		for(unsigned s=0; s<numStrips; s++)
+			palette_expand4(packet + LB_HEADER_SIZE, packet + LB_HEADER_SIZE + s, expanded, pixelsPerStrand);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	micros = ElapsedMicros(&start, &end) / iterations;
+	printf("benchmark: palette 4 bit      %8.1f us/frame (%5.1f%% of 50Hz budget)\n", micros, 100 * micros / frameBudgetMicros);
+	free(expanded);
+
+	dither_t *benchDither = dither_init(numStrips, pixelsPerStrand, highDepthGamma);
+	for(unsigned s=0; s<numStrips; s++)
+		memcpy(dither_strip(benchDither, s), packet + LB_HEADER_SIZE, pixelsPerStrand * sizeof(dither_pixel_t));
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int it=0; it<iterations; it++) {
+		for(unsigned s=0; s<numStrips; s++)
+			dither_strip_to_frame(benchDither, frame, s, rgbwOutput);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	micros = ElapsedMicros(&start, &end) / iterations;
+	printf("benchmark: dither 16 bit      %8.1f us/frame (%5.1f%% of 50Hz budget)\n", micros, 100 * micros / frameBudgetMicros);
+	dither_close(benchDither);
+
+	// committing a frame without calibration
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int it=0; it<iterations; it++)
+		memcpy(out, frame, ledscape_frame_size(numStrips, pixelsPerStrand));
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	micros = ElapsedMicros(&start, &end) / iterations;
+	printf("benchmark: commit copy        %8.1f us/frame (%5.1f%% of 50Hz budget)\n", micros, 100 * micros / frameBudgetMicros);
+
+	calibration_t *benchCalibration = calibrationFile ?
+		calibration_load(calibrationFile, numStrips, pixelsPerStrand, rgbwOutput) :
+		calibration_init(numStrips, pixelsPerStrand);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int it=0; it<iterations; it++)
+		calibration_apply(benchCalibration, out, frame);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	micros = ElapsedMicros(&start, &end) / iterations;
+	printf("benchmark: calibration        %8.1f us/frame (%5.1f%% of 50Hz budget)\n", micros, 100 * micros / frameBudgetMicros);
+	calibration_close(benchCalibration);
+
+#ifdef LEDBURN_PROFILE
+	// the profiler's own cost, for a frame of a segment per strip: 4 stages a segment, and 4 a frame
+	PROFILE_INIT(stageNames, NUM_STAGES);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int it=0; it<iterations; it++) {
+		for(unsigned i=0; i<numStrips * 4 + 4; i++) {
+			PROFILE_START(stageStart);
+			PROFILE_END(STAGE_VERIFY, stageStart);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	micros = ElapsedMicros(&start, &end) / iterations;
+	printf("benchmark: profiler           %8.1f us/frame (%5.1f%% of 50Hz budget)\n", micros, 100 * micros / frameBudgetMicros);
+#endif
+
+	printf("benchmark: frames are in cached memory, writes to the PRU DDR are slower\n");
+	free(packet);
+	free(frame);
+	free(out);
+	frame = NULL;
+}
+
+void PrintUsage(const char *progName) {
+	fprintf(stderr,
+		"usage: %s [options] [pixels per strand]\n"
+		"  -m, --mode <mode>  output protocol, one of the modes listed by --list-modes (default ws281x)\n"
+		"  -M, --mapping <m>  pin mapping, from pru/mappings (default come-million-box)\n"
+		"  -l, --list-modes   print the output modes and their frame rate for the strand length, and exit\n"
+		"  -w, --rgbw         same as --mode sk6812\n"
+		"  -s, --strips <n>   number of strips in use, rounded up to a multiple of %d (default %d)\n"
+		"  -g, --gamma <g>    gamma applied to 16 and 12 bit payloads (default 1.0)\n"
+		"  -c, --calibration <file>\n"
+		"                     per strip / per pixel color gains, see calibration.h\n"
+		"  -j, --multicast <group>\n"
+		"                     join an IPv4 or IPv6 multicast group on port 2000\n"
+		"  -i, --multicast-interface <if>\n"
+		"                     interface to join the group on (default: chosen by the routing table)\n"
+		"  -o, --strip-offset <n>\n"
+		"                     global strip id of the first strip. other strips are left to other controllers\n"
+		"  -C, --controller <id>\n"
+		"                     same as --strip-offset <id> * strips\n"
+		"  -t, --clock-master <host[:port]>\n"
+		"                     sync with this clock master (default port 2001), and honor frame presentation times\n"
+		"  -T, --serve-clock <port>\n"
+		"                     only answer clock sync requests, as a stand-in clock master for testing\n"
+		"  -e, --telemetry <ms>\n"
+		"                     send counters back to the sender this often (default: never)\n"
+		"  -S, --merge <all|any>\n"
+		"                     with several senders, send a frame once all of them completed one, or once any did (default all)\n"
+		"  -a, --artnet <universe>\n"
+		"                     also receive Art-Net on port %d, mapping universes onto strips from this one\n"
+		"  -E, --e131 <universe>\n"
+		"                     also receive sACN (E1.31) on port %d, mapping universes onto strips from this one\n"
+		"  -p, --e131-merge <htp|ltp>\n"
+		"                     merge of E1.31 sources with the same priority (default htp)\n"
+		"  -A, --universe-pixels <n>\n"
+		"                     RGB pixels in a universe (default %d)\n"
+		"  -u, --universe-map <file>\n"
+		"                     map Art-Net and E1.31 universes onto strips by this file, see universe.h\n"
+		"  -O, --opc <port>   also receive Open Pixel Control on this TCP and UDP port (usually %d)\n"
+		"  -D, --ddp          also receive DDP on port %d\n"
+		"  -G, --gro          let the kernel coalesce LedBurn datagrams from a sender into one read (UDP_GRO)\n"
+		"  -X, --xdp <if[:queue]>\n"
+		"                     receive LedBurn on this interface and queue (default 0) with AF_XDP, past the stack\n"
+		"  -x, --xdp-mode <auto|native|generic>\n"
+		"                     where the XDP program runs: the driver, or generic for drivers without XDP (default auto)\n"
+		"  -P, --metrics <port|path>\n"
+		"                     serve Prometheus metrics on this localhost TCP port, or Unix socket path\n"
+		"  -B, --benchmark    time the per frame processing and exit\n"
+		"  -h, --help         print this message\n",
+		progName, LEDSCAPE_STRIP_ALIGN, LEDSCAPE_NUM_STRIPS, ARTNET_PORT, E131_PORT, UNIVERSE_MAX_PIXELS, OPC_DEFAULT_PORT, DDP_PORT);
+}
+
+// parse the options, and return the index of the first positional argument
+int ParseCommandLineOptions(int argc, char ** argv) {
+	static const struct option longOptions[] = {
+		{ "mode", required_argument, NULL, 'm' },
+		{ "mapping", required_argument, NULL, 'M' },
+		{ "list-modes", no_argument, NULL, 'l' },
+		{ "rgbw", no_argument, NULL, 'w' },
+		{ "strips", required_argument, NULL, 's' },
+		{ "gamma", required_argument, NULL, 'g' },
+		{ "calibration", required_argument, NULL, 'c' },
+		{ "multicast", required_argument, NULL, 'j' },
+		{ "multicast-interface", required_argument, NULL, 'i' },
+		{ "strip-offset", required_argument, NULL, 'o' },
+		{ "controller", required_argument, NULL, 'C' },
+		{ "clock-master", required_argument, NULL, 't' },
+		{ "serve-clock", required_argument, NULL, 'T' },
+		{ "telemetry", required_argument, NULL, 'e' },
+		{ "merge", required_argument, NULL, 'S' },
+		{ "artnet", required_argument, NULL, 'a' },
+		{ "e131", required_argument, NULL, 'E' },
+		{ "e131-merge", required_argument, NULL, 'p' },
+		{ "universe-pixels", required_argument, NULL, 'A' },
+		{ "universe-map", required_argument, NULL, 'u' },
+		{ "opc", required_argument, NULL, 'O' },
+		{ "ddp", no_argument, NULL, 'D' },
+		{ "gro", no_argument, NULL, 'G' },
+		{ "xdp", required_argument, NULL, 'X' },
+		{ "xdp-mode", required_argument, NULL, 'x' },
+		{ "metrics", required_argument, NULL, 'P' },
+		{ "benchmark", no_argument, NULL, 'B' },
+		{ "help", no_argument, NULL, 'h' },
+		{ NULL, 0, NULL, 0 }
+	};
+
+	int opt;
+	while((opt = getopt_long(argc, argv, "m:M:lws:g:c:j:i:o:C:t:T:e:S:a:E:p:A:u:O:DGX:x:P:Bh", longOptions, NULL)) != -1) {
+		switch(opt) {
+			case 'm':
+				outputMode = FindOutputMode(optarg);
+				if(outputMode == NULL) {
+					fprintf(stderr, "unknown output mode '%s'. see --list-modes\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+				break;
+			case 'M':
+				outputMapping = optarg;
+				break;
+			case 'l':
+				listOutputModes = true;
+				break;
+			case 'w':
+				outputMode = FindOutputMode("sk6812");
+				break;
+			case 's': {
+				char *endPtr;
+				long strips = strtol(optarg, &endPtr, 10);
+				if(endPtr == optarg || *endPtr != '\0' || strips <= 0 || strips > LEDSCAPE_NUM_STRIPS) {
+					fprintf(stderr, "number of strips should be between [1, %d]. received: '%s'\n", LEDSCAPE_NUM_STRIPS, optarg);
+					exit(EXIT_FAILURE);
+				}
+				numStrips = ledscape_aligned_strips(strips);
+				printf("number of strips set to %u\n", numStrips);
+				break;
+			}
+			case 'g': {
+				char *endPtr;
+				highDepthGamma = strtod(optarg, &endPtr);
+				if(endPtr == optarg || *endPtr != '\0' || highDepthGamma <= 0.0 || highDepthGamma > 5.0) {
+					fprintf(stderr, "gamma should be a number between 0 and 5. received: '%s'\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+				printf("gamma for high bit depth payloads set to %.2f\n", highDepthGamma);
+				break;
+			}
+			case 'c':
+				calibrationFile = optarg;
+				break;
+			case 'j':
+				multicastGroup = optarg;
+				break;
+			case 'i':
+				multicastInterface = optarg;
+				break;
+			case 'o':
+			case 'C': {
+				char *endPtr;
+				long value = strtol(optarg, &endPtr, 10);
+				if(endPtr == optarg || *endPtr != '\0' || value < 0 || value > UINT16_MAX) {
+					fprintf(stderr, "%s should be between [0, %d]. received: '%s'\n", opt == 'o' ? "strip offset" : "controller id", UINT16_MAX, optarg);
+					exit(EXIT_FAILURE);
+				}
+				if(opt == 'o')
+					stripOffset = value;
+				else
+					controllerId = value;
+				break;
+			}
+			case 't':
+				clockMaster = optarg;
+				break;
+			case 'T': {
+				char *endPtr;
+				serveClockPort = strtol(optarg, &endPtr, 10);
+				if(endPtr == optarg || *endPtr != '\0' || serveClockPort <= 0 || serveClockPort > UINT16_MAX) {
+					fprintf(stderr, "clock port should be between [1, %d]. received: '%s'\n", UINT16_MAX, optarg);
+					exit(EXIT_FAILURE);
+				}
+				break;
+			}
+			case 'e': {
+				char *endPtr;
+				telemetryIntervalMs = strtol(optarg, &endPtr, 10);
+				if(endPtr == optarg || *endPtr != '\0' || telemetryIntervalMs < 0) {
+					fprintf(stderr, "telemetry interval should be a number of milliseconds. received: '%s'\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+				break;
+			}
+			case 'S':
+				if(strcmp(optarg, "all") == 0)
+					mergePolicy = MERGE_ALL;
+				else if(strcmp(optarg, "any") == 0)
+					mergePolicy = MERGE_ANY;
+				else {
+					fprintf(stderr, "merge policy should be all or any. received: '%s'\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+				break;
+			case 'a':
+			case 'E': {
+				char *endPtr;
+				const long minUniverse = opt == 'a' ? 0 : 1;
+				const long maxUniverse = opt == 'a' ? ARTNET_MAX_UNIVERSE : E131_MAX_UNIVERSE;
+				long universe = strtol(optarg, &endPtr, 10);
+				if(endPtr == optarg || *endPtr != '\0' || universe < minUniverse || universe > maxUniverse) {
+					fprintf(stderr, "%s universe should be between [%ld, %ld]. received: '%s'\n", opt == 'a' ? "Art-Net" : "E1.31", minUniverse, maxUniverse, optarg);
+					exit(EXIT_FAILURE);
+				}
+				if(opt == 'a')
+					artnetUniverse = universe;
+				else
+					e131Universe = universe;
+				break;
+			}
+			case 'p':
+				if(strcmp(optarg, "htp") == 0)
+					e131MergePolicy = E131_MERGE_HTP;
+				else if(strcmp(optarg, "ltp") == 0)
+					e131MergePolicy = E131_MERGE_LTP;
+				else {
+					fprintf(stderr, "E1.31 merge should be htp or ltp. received: '%s'\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+				break;
+			case 'u':
+				universeMapFile = optarg;
+				break;
+			case 'O': {
+				char *endPtr;
+				opcPort = strtol(optarg, &endPtr, 10);
+				if(endPtr == optarg || *endPtr != '\0' || opcPort <= 0 || opcPort > UINT16_MAX) {
+					fprintf(stderr, "OPC port should be between [1, %d]. received: '%s'\n", UINT16_MAX, optarg);
+					exit(EXIT_FAILURE);
+				}
+				break;
+			}
+			case 'A': {
+				char *endPtr;
+				long pixels = strtol(optarg, &endPtr, 10);
+				if(endPtr == optarg || *endPtr != '\0' || pixels <= 0 || pixels > UNIVERSE_MAX_PIXELS) {
+					fprintf(stderr, "pixels per universe should be between [1, %d]. received: '%s'\n", UNIVERSE_MAX_PIXELS, optarg);
+					exit(EXIT_FAILURE);
+				}
+				universePixels = pixels;
+				break;
+			}
+			case 'D':
+				ddpEnabled = true;
+				break;
+			case 'G':
+				groEnabled = true;
+				break;
+			case 'X':
+				xdpInterface = optarg;
+				break;
+			case 'x':
+				if(strcmp(optarg, "auto") == 0)
+					xdpMode = XSK_MODE_AUTO;
+				else if(strcmp(optarg, "native") == 0)
+					xdpMode = XSK_MODE_NATIVE;
+				else if(strcmp(optarg, "generic") == 0)
+					xdpMode = XSK_MODE_GENERIC;
+				else {
+					fprintf(stderr, "XDP mode should be auto, native or generic. received: '%s'\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+				break;
+			case 'P':
+				metricsEndpoint = optarg;
+				break;
+			case 'B':
+				runBenchmark = true;
+				break;
+			case 'h':
+				PrintUsage(argv[0]);
+				exit(EXIT_SUCCESS);
+			default:
+				PrintUsage(argv[0]);
+				exit(EXIT_FAILURE);
+		}
+	}
+
+	// the controller id depends on the number of strips, which may come after it
+	if(controllerId >= 0)
+		stripOffset = controllerId * numStrips;
+	if(stripOffset > 0)
+		printf("strips %u - %u of the stream are ours\n", stripOffset, stripOffset + numStrips - 1);
+
+	return optind;
+}
+
+int main(int argc, char ** argv)
+{
+	int argIndex = ParseCommandLineOptions(argc, argv);
+	SetNumberOfPixelsInStrand(argIndex < argc ? argv[argIndex] : NULL);
+	if(listOutputModes) {
+		PrintOutputModes(pixelsPerStrand);
+		return 0;
+	}
+	if(serveClockPort) {
+		ServeClock(serveClockPort);
+	}
+	ValidateOutputMode();
+	InitUniverseMaps();
+	InitMetrics();
+	if(runBenchmark) {
+		RunBenchmark();
+		return 0;
+	}
+	PROFILE_INIT(stageNames, NUM_STAGES);
+	LoadCalibration();
+	StartLedScape();
+	PlayInitSequence();
+	MainLoop();
+}
@@ -65,6 +65,12 @@ typedef struct ws281x_command
 
 	// will have a non-zero response written when done
 	volatile unsigned response;
+
+	// bytes from one pixel row of the frame to the next
+	uint16_t row_stride;
+
+	// number of strips this PRU outputs, counted from its first channel
+	uint16_t num_channels;
 } __attribute__((__packed__)) ws281x_command_t;
 
 
@@ -145,10 +151,33 @@ ledscape_t * ledscape_init_with_programs(
 	const char* pru1_program_filename
 )
 {
+	return ledscape_init_with_strips(
+		LEDSCAPE_NUM_STRIPS,
+		LEDSCAPE_STRIPS_PER_PRU,
+		num_pixels,
+		pru0_program_filename,
+		pru1_program_filename
+	);
+}
+
+ledscape_t * ledscape_init_with_strips(
+	unsigned num_strips,
+	unsigned strips_per_pru,
+	unsigned num_pixels,
+	const char* pru0_program_filename,
+	const char* pru1_program_filename
+)
+{
+	if (num_strips == 0 || num_strips > LEDSCAPE_NUM_STRIPS)
+		die("Number of strips %u is not in [1, %d]\n", num_strips, LEDSCAPE_NUM_STRIPS);
+	if (strips_per_pru == 0 || strips_per_pru > LEDSCAPE_STRIPS_PER_PRU || num_strips > 2 * strips_per_pru)
+		die("%u strips don't fit in two PRUs of %u strips\n", num_strips, strips_per_pru);
+	num_strips = ledscape_aligned_strips(num_strips);
+
 	pru_t * const pru0 = pru_init(0);
 	pru_t * const pru1 = pru_init(1);
 
-	const size_t frame_size = num_pixels * LEDSCAPE_NUM_STRIPS * 4;
+	const size_t frame_size = ledscape_frame_size(num_strips, num_pixels);
 
 	if (2*frame_size > pru0->ddr_size)
 		die("Pixel data needs at least 2 * %zu, only %zu in DDR\n",
@@ -162,6 +191,7 @@ ledscape_t * ledscape_init_with_programs(
 		.pru0		= pru0,
 		.pru1		= pru1,
 		.num_pixels	= num_pixels,
+		.num_strips	= num_strips,
 		.frame_size	= frame_size,
 		.pru0_program_filename  = pru0_program_filename,
 		.pru1_program_filename  = pru1_program_filename,
@@ -174,8 +204,13 @@ ledscape_t * ledscape_init_with_programs(
 		.command	= 0,
 		.response	= 0,
 		.num_pixels	= leds->num_pixels,
+		.row_stride	= num_strips * sizeof(ledscape_pixel_t),
 	};
 
+	const unsigned pru0_channels = num_strips < strips_per_pru ? num_strips : strips_per_pru;
+	leds->ws281x_0->num_channels = pru0_channels;
+	leds->ws281x_1->num_channels = num_strips - pru0_channels;
+
 	// Configure all of our output pins.
 	for (unsigned i = 0 ; i < ARRAY_COUNT(gpios0) ; i++)
 		pru_gpio(0, gpios0[i], 1, 0);
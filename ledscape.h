@@ -12,13 +12,21 @@
 #include <stdbool.h>
 #include "pru.h"
 
-/** The number of strips supported.
+/** The maximum number of strips supported.
  *
- * Changing this also requires changes in ws281x.p to stride the
- * correct number of bytes per row..
+ * The number of strips actually in use is set by ledscape_init_with_strips(),
+ * and sets the number of pixels in each row of the frame.
  */
 #define LEDSCAPE_NUM_STRIPS 48
 
+/** Each PRU drives half of the ws281x outputs */
+#define LEDSCAPE_STRIPS_PER_PRU (LEDSCAPE_NUM_STRIPS / 2)
+
+/** The number of strips in use is rounded up to a multiple of this,
+ * since the PRU loads channel data in blocks of 8 registers.
+ */
+#define LEDSCAPE_STRIP_ALIGN 8
+
 
 /**
  * An LEDscape "pixel" consists of three channels of output and an unused fourth channel. The color mapping of these
@@ -35,9 +43,13 @@ typedef struct {
 
 /** LEDscape frame buffer is "strip-major".
  *
- * All 32 strips worth of data for each pixel are stored adjacent.
+ * All strips worth of data for each pixel are stored adjacent.
  * This makes it easier to clock out while reading from the DDR
  * in a burst mode.
+ *
+ * A row holds leds->num_strips pixels, so only frames of all
+ * LEDSCAPE_NUM_STRIPS strips can be indexed as an array of
+ * ledscape_frame_t. Use ledscape_pixel() to address a pixel.
  */
 typedef struct {
 	ledscape_pixel_t strip[LEDSCAPE_NUM_STRIPS];
@@ -53,6 +65,7 @@ typedef struct {
 	const char* pru0_program_filename;
 	const char* pru1_program_filename;
 	unsigned num_pixels;
+	unsigned num_strips;
 	size_t frame_size;
 } ledscape_t;
 
@@ -77,6 +90,50 @@ extern ledscape_t * ledscape_init_with_programs(
 	const char* pru1_program_filename
 );
 
+/** Initialize for the first num_strips strips only.
+ *
+ * num_strips is rounded up to a multiple of LEDSCAPE_STRIP_ALIGN,
+ * and is available as leds->num_strips. Frames are that many
+ * pixels wide, so the ARM writes and the PRU reads less memory
+ * when fewer strips are connected.
+ *
+ * PRU0 outputs the first strips_per_pru strips and PRU1 the rest,
+ * as the programs expect: LEDSCAPE_STRIPS_PER_PRU for ws281x, and
+ * half of that for clocked strips, which take two pins each.
+ */
+extern ledscape_t * ledscape_init_with_strips(
+	unsigned num_strips,
+	unsigned strips_per_pru,
+	unsigned num_pixels,
+	const char* pru0_program_filename,
+	const char* pru1_program_filename
+);
+
+/** The number of strips in a frame row for num_strips strips in use */
+static inline unsigned ledscape_aligned_strips(
+	unsigned num_strips
+) {
+	return (num_strips + LEDSCAPE_STRIP_ALIGN - 1) / LEDSCAPE_STRIP_ALIGN * LEDSCAPE_STRIP_ALIGN;
+}
+
+/** Size in bytes of a frame of num_pixels in a num_strips wide frame */
+static inline size_t ledscape_frame_size(
+	unsigned num_strips,
+	unsigned num_pixels
+) {
+	return (size_t) num_pixels * num_strips * sizeof(ledscape_pixel_t);
+}
+
+/** Address of one pixel in a frame that is num_strips wide */
+static inline ledscape_pixel_t * ledscape_pixel(
+	ledscape_frame_t * const frame,
+	unsigned num_strips,
+	unsigned strip,
+	unsigned pixel
+) {
+	return (ledscape_pixel_t *) frame + pixel * num_strips + strip;
+}
+
 
 extern ledscape_frame_t *
 ledscape_frame(
@@ -136,8 +193,9 @@ ledscape_draw(
 	}
 }*/
 
-inline void ledscape_set_color(
+static inline void ledscape_set_color(
 	ledscape_frame_t * const frame,
+	unsigned num_strips,
 	color_channel_order_t color_channel_order,
 	uint8_t strip,
 	uint16_t pixel,
@@ -146,7 +204,7 @@ inline void ledscape_set_color(
 	uint8_t b
 ) {
 	(void)color_channel_order;
-	ledscape_pixel_t * const out_pixel = &frame[pixel].strip[strip];
+	ledscape_pixel_t * const out_pixel = ledscape_pixel(frame, num_strips, strip, pixel);
 	out_pixel->a = b;	
 	out_pixel->b = g;
 	out_pixel->c = r;
@@ -159,6 +217,49 @@ inline void ledscape_set_color(
 	);*/
 }
 
+/** Write a 4 channel pixel for sk6812 RGBW strips.
+ *
+ * The sk6812 program clocks out the unused byte first, then c, b and a,
+ * so the channels reach the strip in the order they are passed here.
+ */
+static inline void ledscape_set_color_rgbw(
+	ledscape_frame_t * const frame,
+	unsigned num_strips,
+	uint8_t strip,
+	uint16_t pixel,
+	uint8_t r,
+	uint8_t g,
+	uint8_t b,
+	uint8_t w
+) {
+	ledscape_pixel_t * const out_pixel = ledscape_pixel(frame, num_strips, strip, pixel);
+	out_pixel->unused = r;
+	out_pixel->c = g;
+	out_pixel->b = b;
+	out_pixel->a = w;
+}
+
+/** Write an RGB color to an RGBW pixel, moving the common white part
+ * of the three channels to the dedicated white led.
+ *
+ * w = min(r, g, b) is subtracted from every channel, which keeps the
+ * color and drives the more efficient white led instead of mixing it.
+ */
+static inline void ledscape_set_color_rgb_to_rgbw(
+	ledscape_frame_t * const frame,
+	unsigned num_strips,
+	uint8_t strip,
+	uint16_t pixel,
+	uint8_t r,
+	uint8_t g,
+	uint8_t b
+) {
+	uint8_t w = r < g ? r : g;
+	if (b < w)
+		w = b;
+	ledscape_set_color_rgbw(frame, num_strips, strip, pixel, r - w, g - w, b - w, w);
+}
+
 extern void
 ledscape_wait(
 	ledscape_t * const leds
@@ -0,0 +1,180 @@
+/** \file
+ * LZ4 block format, for compressed LedBurn segments.
+ */
+#include <string.h>
+#include "lz4_block.h"
+
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5 // the last bytes of a block are always literals
+#define LZ4_MF_LIMIT 12 // and the last match starts before this many bytes from the end
+#define LZ4_HASH_BITS 12
+
+
+// read the extra length bytes of a 15 nibble
+static int
+lz4_read_length(
+	const uint8_t ** in,
+	const uint8_t * const in_end,
+	size_t * len
+)
+{
+	uint8_t b;
+	do {
+		if (*in >= in_end)
+			return -1;
+		b = *(*in)++;
+		*len += b;
+	} while (b == 255);
+	return 0;
+}
+
+
+int
+lz4_block_decompress(
+	const uint8_t * in,
+	size_t in_len,
+	uint8_t * out,
+	size_t out_size
+)
+{
+	const uint8_t * const in_end = in + in_len;
+	uint8_t * const out_start = out;
+	uint8_t * const out_end = out + out_size;
+
+	while (in < in_end)
+	{
+		const uint8_t token = *in++;
+
+		size_t literals = token >> 4;
+		if (literals == 15 && lz4_read_length(&in, in_end, &literals) < 0)
+			return -1;
+		if (literals > (size_t)(in_end - in) || literals > (size_t)(out_end - out))
+			return -1;
+		memcpy(out, in, literals);
+		in += literals;
+		out += literals;
+
+		// the last sequence has no match
+		if (in == in_end)
+			break;
+
+		if (in_end - in < 2)
+			return -1;
+		const size_t offset = in[0] | (in[1] << 8);
+		in += 2;
+		if (offset == 0 || offset > (size_t)(out - out_start))
+			return -1;
+
+		size_t match = token & 0xF;
+		if (match == 15 && lz4_read_length(&in, in_end, &match) < 0)
+			return -1;
+		match += LZ4_MIN_MATCH;
+		if (match > (size_t)(out_end - out))
+			return -1;
+
+		// matches may overlap their own output, so copy forward byte by byte
+		const uint8_t * ref = out - offset;
+		for (size_t i = 0 ; i < match ; i++)
+			out[i] = ref[i];
+		out += match;
+	}
+
+	return out - out_start;
+}
+
+
+static uint8_t *
+lz4_write_length(
+	uint8_t * out,
+	size_t len
+)
+{
+	while (len >= 255)
+	{
+		*out++ = 255;
+		len -= 255;
+	}
+	*out++ = len;
+	return out;
+}
+
+
+static uint8_t *
+lz4_write_sequence(
+	uint8_t * out,
+	const uint8_t * literals,
+	size_t num_literals,
+	size_t offset,
+	size_t match
+)
+{
+	uint8_t * const token = out++;
+	*token = (num_literals < 15 ? num_literals : 15) << 4;
+	if (num_literals >= 15)
+		out = lz4_write_length(out, num_literals - 15);
+	memcpy(out, literals, num_literals);
+	out += num_literals;
+
+	if (match == 0)
+		return out;
+
+	*out++ = offset & 0xFF;
+	*out++ = offset >> 8;
+	match -= LZ4_MIN_MATCH;
+	*token |= match < 15 ? match : 15;
+	if (match >= 15)
+		out = lz4_write_length(out, match - 15);
+	return out;
+}
+
+
+static inline uint32_t
+lz4_hash(
+	const uint8_t * p
+)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return (v * 2654435761U) >> (32 - LZ4_HASH_BITS);
+}
+
+
+size_t
+lz4_block_compress(
+	const uint8_t * in,
+	size_t len,
+	uint8_t * out
+)
+{
+	uint8_t * const out_start = out;
+	const uint8_t * anchor = in;
+	size_t table[1 << LZ4_HASH_BITS];
+	memset(table, 0xFF, sizeof(table));
+
+	size_t i = 0;
+	while (len >= LZ4_MF_LIMIT && i + LZ4_MF_LIMIT <= len)
+	{
+		const uint32_t h = lz4_hash(in + i);
+		const size_t candidate = table[h];
+		table[h] = i;
+
+		if (candidate == (size_t) -1
+		||  i - candidate > 0xFFFF
+		||  memcmp(in + candidate, in + i, LZ4_MIN_MATCH) != 0)
+		{
+			i++;
+			continue;
+		}
+
+		size_t match = LZ4_MIN_MATCH;
+		while (i + match < len - LZ4_LAST_LITERALS
+		&&     in[candidate + match] == in[i + match])
+			match++;
+
+		out = lz4_write_sequence(out, anchor, in + i - anchor, i - candidate, match);
+		i += match;
+		anchor = in + i;
+	}
+
+	return lz4_write_sequence(out, anchor, in + len - anchor, 0, 0) - out_start;
+}
@@ -0,0 +1,45 @@
+/** \file
+ * LZ4 block format, for compressed LedBurn segments.
+ *
+ * Only the block format is supported (no frame header, checksums or
+ * dictionaries), since every segment is compressed on its own and its
+ * size is known from the datagram. The format is described in
+ * lz4_Block_format.md of the reference implementation.
+ */
+#ifndef _lz4_block_h_
+#define _lz4_block_h_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** Decompress an LZ4 block into out.
+ *
+ * \returns the decompressed size, or -1 if the block is malformed or
+ * does not fit in out_size bytes.
+ */
+extern int
+lz4_block_decompress(
+	const uint8_t * in,
+	size_t in_len,
+	uint8_t * out,
+	size_t out_size
+);
+
+/** Worst case size of a compressed block of len bytes */
+#define LZ4_BLOCK_BOUND(len) ((len) + (len) / 255 + 16)
+
+/** Compress len bytes into out, which must hold LZ4_BLOCK_BOUND(len) bytes.
+ *
+ * A simple greedy compressor, good enough for testing and benchmarks.
+ * Senders should use the reference implementation.
+ *
+ * \returns the compressed size.
+ */
+extern size_t
+lz4_block_compress(
+	const uint8_t * in,
+	size_t len,
+	uint8_t * out
+);
+
+#endif
@@ -0,0 +1,265 @@
+/** \file
+ * Counters and gauges, read by a Prometheus scrape.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "metrics.h"
+#include "util.h"
+
+static metric_t metrics[METRICS_MAX];
+static unsigned num_metrics;
+
+#define METRICS_RESPONSE_SIZE 16384
+
+
+static metric_t *
+metrics_add_entry(
+	const char * name,
+	metrics_type_t type,
+	const char * help
+)
+{
+	if (num_metrics >= METRICS_MAX)
+		die("metrics: more than %d metrics\n", METRICS_MAX);
+	metric_t * const metric = &metrics[num_metrics];
+	memset(metric, 0, sizeof(*metric));
+	metric->name = name;
+	metric->type = type;
+	metric->help = help;
+	return metric;
+}
+
+// the entry is complete before a reader can see it
+static void
+metrics_publish(void)
+{
+	__atomic_store_n(&num_metrics, num_metrics + 1, __ATOMIC_RELEASE);
+}
+
+
+metric_t *
+metrics_register(
+	const char * name,
+	metrics_type_t type,
+	const char * help
+)
+{
+	metric_t * const metric = metrics_add_entry(name, type, help);
+	metrics_publish();
+	return metric;
+}
+
+
+void
+metrics_register_u32(
+	const char * name,
+	metrics_type_t type,
+	const char * help,
+	const uint32_t * value
+)
+{
+	metrics_add_entry(name, type, help)->u32 = value;
+	metrics_publish();
+}
+
+
+void
+metrics_register_fn(
+	const char * name,
+	metrics_type_t type,
+	const char * help,
+	uint64_t (*read)(void)
+)
+{
+	metrics_add_entry(name, type, help)->read = read;
+	metrics_publish();
+}
+
+
+uint64_t
+metrics_get(
+	const metric_t * const metric
+)
+{
+	if (metric->read)
+		return metric->read();
+	if (metric->u32)
+		return __atomic_load_n(metric->u32, __ATOMIC_RELAXED);
+	return __atomic_load_n(&metric->value, __ATOMIC_RELAXED);
+}
+
+
+size_t
+metrics_format(
+	char * buf,
+	size_t size
+)
+{
+	const unsigned count = __atomic_load_n(&num_metrics, __ATOMIC_ACQUIRE);
+	size_t len = 0;
+	buf[0] = '\0';
+	for (unsigned i = 0 ; i < count && len < size ; i++) {
+		const metric_t * const metric = &metrics[i];
+		len += snprintf(buf + len, size - len, "# HELP %s %s\n# TYPE %s %s\n%s %" PRIu64 "\n",
+			metric->name, metric->help,
+			metric->name, metric->type == METRICS_COUNTER ? "counter" : "gauge",
+			metric->name, metrics_get(metric));
+	}
+	return len < size ? len : size - 1;
+}
+
+
+// a client that went away, like a scrape that timed out, fails the send
+// rather than raising SIGPIPE, which would end the whole server
+static bool
+metrics_send_all(
+	int fd,
+	const char * buf,
+	size_t len
+)
+{
+	while (len > 0) {
+		const ssize_t rc = send(fd, buf, len, MSG_NOSIGNAL);
+		if (rc < 0 && errno == EINTR)
+			continue;
+		if (rc <= 0)
+			return false;
+		buf += rc;
+		len -= rc;
+	}
+	return true;
+}
+
+
+// answer each connection with the metrics, whatever it asked for
+static void *
+metrics_thread(
+	void * arg
+)
+{
+	const int listen_fd = (intptr_t) arg;
+	static char body[METRICS_RESPONSE_SIZE];
+	char header[128];
+	char request[1024];
+
+	for (;;) {
+		const int fd = accept(listen_fd, NULL, NULL);
+		if (fd < 0) {
+			if (errno != EINTR)
+				warn_once("metrics: accept failed: %s\n", strerror(errno));
+			continue;
+		}
+
+		// read the request, so closing doesn't reset the connection before the client read the response
+		const struct timeval timeout = { .tv_sec = 1 };
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		ssize_t got = 0, rc;
+		while (got < (ssize_t) sizeof(request) - 1
+		&& (rc = read(fd, request + got, sizeof(request) - 1 - got)) > 0) {
+			got += rc;
+			request[got] = '\0';
+			if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n"))
+				break;
+		}
+
+		const size_t len = metrics_format(body, sizeof(body));
+		const int header_len = snprintf(header, sizeof(header),
+			"HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\n\r\n", len);
+		if (metrics_send_all(fd, header, header_len))
+			metrics_send_all(fd, body, len);
+		close(fd);
+	}
+	return NULL;
+}
+
+
+static int
+metrics_listen_tcp(
+	int port
+)
+{
+	const int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0)
+		return -1;
+	const int one = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(port);
+	if (bind(fd, (const struct sockaddr *) &addr, sizeof(addr)) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+
+static int
+metrics_listen_unix(
+	const char * path
+)
+{
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	strcpy(addr.sun_path, path);
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		return -1;
+	unlink(path); // left by an earlier run
+	if (bind(fd, (const struct sockaddr *) &addr, sizeof(addr)) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+
+bool
+metrics_serve(
+	const char * where
+)
+{
+	char * end;
+	const long port = strtol(where, &end, 10);
+	const bool tcp = end != where && *end == '\0';
+	if (tcp && (port <= 0 || port > UINT16_MAX)) {
+		warn("metrics: port should be between [1, %d]. received: '%s'\n", UINT16_MAX, where);
+		return false;
+	}
+
+	const int fd = tcp ? metrics_listen_tcp(port) : metrics_listen_unix(where);
+	if (fd < 0 || listen(fd, 4) < 0) {
+		warn("metrics: listening on %s failed: %s\n", where, strerror(errno));
+		if (fd >= 0)
+			close(fd);
+		return false;
+	}
+
+	pthread_t thread;
+	const int rc = pthread_create(&thread, NULL, metrics_thread, (void *)(intptr_t) fd);
+	if (rc != 0) {
+		warn("metrics: thread failed: %s\n", strerror(rc));
+		close(fd);
+		return false;
+	}
+	pthread_detach(thread);
+	return true;
+}
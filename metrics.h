@@ -0,0 +1,114 @@
+/** \file
+ * Counters and gauges, read by a Prometheus scrape.
+ *
+ * The main loop is the only writer. A metric is either kept here, as a
+ * 64 bit value updated with relaxed atomics, or is a 32 bit variable of
+ * the caller's, which is written whole on every CPU we run on, or is
+ * read by a function. Readers, the endpoint's thread, load the values
+ * without a lock, so scraping never stalls the packet loop.
+ *
+ * The endpoint answers every connection with the text exposition format,
+ * as an HTTP response, on a localhost TCP port or a Unix socket:
+ *
+ *	curl http://127.0.0.1:9100/metrics
+ *	curl --unix-socket /run/ledburn.sock http://x/metrics
+ *
+ * Metrics are registered at startup, before metrics_serve().
+ */
+#ifndef _metrics_h_
+#define _metrics_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define METRICS_MAX 48
+
+typedef enum {
+	METRICS_COUNTER,
+	METRICS_GAUGE,
+} metrics_type_t;
+
+typedef struct {
+	const char * name;
+	const char * help;
+	metrics_type_t type;
+	uint64_t value; // if kept here
+	const uint32_t * u32; // if it is the caller's
+	uint64_t (*read)(void); // if it is read by a function
+} metric_t;
+
+
+/** A metric kept by the registry. dies if there are too many. */
+extern metric_t *
+metrics_register(
+	const char * name,
+	metrics_type_t type,
+	const char * help
+);
+
+/** A 32 bit variable of the caller's, like a telemetry counter */
+extern void
+metrics_register_u32(
+	const char * name,
+	metrics_type_t type,
+	const char * help,
+	const uint32_t * value
+);
+
+/** A value read by a function when the metrics are scraped. It runs on
+ * the endpoint's thread.
+ */
+extern void
+metrics_register_fn(
+	const char * name,
+	metrics_type_t type,
+	const char * help,
+	uint64_t (*read)(void)
+);
+
+static inline void
+metrics_add(
+	metric_t * const metric,
+	uint64_t n
+)
+{
+	__atomic_fetch_add(&metric->value, n, __ATOMIC_RELAXED);
+}
+
+static inline void
+metrics_set(
+	metric_t * const metric,
+	uint64_t value
+)
+{
+	__atomic_store_n(&metric->value, value, __ATOMIC_RELAXED);
+}
+
+extern uint64_t
+metrics_get(
+	const metric_t * const metric
+);
+
+/** Write all the metrics in the text exposition format.
+ *
+ * \returns the length, truncated to size - 1.
+ */
+extern size_t
+metrics_format(
+	char * buf,
+	size_t size
+);
+
+/** Serve the metrics from a thread, on 127.0.0.1:port if where is a
+ * number, or on a Unix socket at the path where.
+ *
+ * \returns false if the socket couldn't be opened, with the reason
+ * printed.
+ */
+extern bool
+metrics_serve(
+	const char * where
+);
+
+#endif
@@ -0,0 +1,78 @@
+/** \file
+ * Expand palette indexed pixels to RGB.
+ */
+#include <string.h>
+#include "palette.h"
+
+#ifdef __ARM_NEON__
+#include <arm_neon.h>
+#endif
+
+
+void
+palette_expand8(
+	const uint8_t palette[PALETTE8_ENTRIES * 3],
+	const uint8_t * indices,
+	uint8_t * rgb,
+	unsigned num_pixels
+)
+{
+	// NEON table lookups are limited to 32 entries. 8 chained lookups per channel
+	// for every 8 pixels cost about as much as this plain loop on the Cortex-A8
+	for (unsigned i = 0 ; i < num_pixels ; i++, rgb += 3)
+		memcpy(rgb, &palette[indices[i] * 3], 3);
+}
+
+
+void
+palette_expand4(
+	const uint8_t palette[PALETTE4_ENTRIES * 3],
+	const uint8_t * indices,
+	uint8_t * rgb,
+	unsigned num_pixels
+)
+{
+	unsigned i = 0;
+
+#ifdef __ARM_NEON__
+	// split the palette into one 16 entry table per channel,
+	// then look up 16 pixels (8 index bytes) at a time
+	uint8_t planes[3][PALETTE4_ENTRIES];
+	for (unsigned e = 0 ; e < PALETTE4_ENTRIES ; e++)
+		for (unsigned c = 0 ; c < 3 ; c++)
+			planes[c][e] = palette[e * 3 + c];
+
+	uint8x8x2_t tables[3];
+	for (unsigned c = 0 ; c < 3 ; c++)
+	{
+		tables[c].val[0] = vld1_u8(planes[c]);
+		tables[c].val[1] = vld1_u8(planes[c] + 8);
+	}
+
+	for ( ; i + 16 <= num_pixels ; i += 16, indices += 8)
+	{
+		const uint8x8_t packed = vld1_u8(indices);
+
+		// interleave the low and high nibbles back into pixel order
+		const uint8x8x2_t index = vzip_u8(
+			vand_u8(packed, vdup_n_u8(0xF)),
+			vshr_n_u8(packed, 4)
+		);
+
+		for (unsigned half = 0 ; half < 2 ; half++, rgb += 24)
+		{
+			uint8x8x3_t out;
+			out.val[0] = vtbl2_u8(tables[0], index.val[half]);
+			out.val[1] = vtbl2_u8(tables[1], index.val[half]);
+			out.val[2] = vtbl2_u8(tables[2], index.val[half]);
+			vst3_u8(rgb, out);
+		}
+	}
+#endif
+
+	for ( ; i < num_pixels ; i++, rgb += 3)
+	{
+		const uint8_t index = (i & 1) ? *indices++ >> 4 : *indices & 0xF;
+		memcpy(rgb, &palette[index * 3], 3);
+	}
+}
@@ -0,0 +1,34 @@
+/** \file
+ * Expand palette indexed pixels to RGB.
+ *
+ * Palettes are tables of 3 byte RGB entries, always full size (256
+ * entries for 8 bit indices, 16 for 4 bit indices), so that an index
+ * past the entries that were sent reads black instead of past the end.
+ */
+#ifndef _palette_h_
+#define _palette_h_
+
+#include <stdint.h>
+
+#define PALETTE8_ENTRIES 256
+#define PALETTE4_ENTRIES 16
+
+/** One index byte per pixel */
+extern void
+palette_expand8(
+	const uint8_t palette[PALETTE8_ENTRIES * 3],
+	const uint8_t * indices,
+	uint8_t * rgb,
+	unsigned num_pixels
+);
+
+/** Two pixels per index byte, the first pixel in the low nibble */
+extern void
+palette_expand4(
+	const uint8_t palette[PALETTE4_ENTRIES * 3],
+	const uint8_t * indices,
+	uint8_t * rgb,
+	unsigned num_pixels
+);
+
+#endif
@@ -0,0 +1,97 @@
+/** \file
+ * Per stage timing of the packet loop.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "profile.h"
+#include "util.h"
+
+profile_t profile;
+
+#define NS_PER_SECOND UINT64_C(1000000000)
+
+
+static void
+profile_request_dump(
+	int sig
+)
+{
+	(void) sig;
+	profile.dump_requested = 1;
+}
+
+
+void
+profile_init(
+	const char * const names[],
+	unsigned num_stages
+)
+{
+	memset(&profile, 0, sizeof(profile));
+	profile.names = names;
+	profile.num_stages = num_stages;
+	profile.ring = calloc(PROFILE_SECONDS * num_stages, sizeof(*profile.ring));
+	profile.second_start_ns = calloc(PROFILE_SECONDS, sizeof(*profile.second_start_ns));
+	if (!profile.ring || !profile.second_start_ns)
+		die("profile: unable to allocate\n");
+
+	const uint64_t now = profile_now();
+	profile.second_start_ns[0] = now - now % NS_PER_SECOND;
+	profile.second_end_ns = profile.second_start_ns[0] + NS_PER_SECOND;
+	profile.filled = 1;
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = profile_request_dump;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = SA_RESTART;
+	sigaction(SIGUSR1, &action, NULL);
+}
+
+
+void
+profile_rotate(
+	uint64_t now
+)
+{
+	// seconds where nothing was recorded are skipped, and not kept
+	profile.current = (profile.current + 1) % PROFILE_SECONDS;
+	memset(&profile.ring[profile.current * profile.num_stages], 0, profile.num_stages * sizeof(*profile.ring));
+	profile.second_start_ns[profile.current] = now - now % NS_PER_SECOND;
+	profile.second_end_ns = profile.second_start_ns[profile.current] + NS_PER_SECOND;
+	if (profile.filled < PROFILE_SECONDS)
+		profile.filled++;
+}
+
+
+void
+profile_poll(void)
+{
+	if (!profile.dump_requested)
+		return;
+	profile.dump_requested = 0;
+	profile_print();
+}
+
+
+// the seconds from the oldest, one line per stage with the time it took, as a share of the second
+void
+profile_print(void)
+{
+	printf("profile: %u seconds, stage: calls, total, share of the second, p50 p99 max ns\n", profile.filled);
+	for (unsigned i = profile.filled ; i > 0 ; i--) {
+		const unsigned slot = (profile.current + PROFILE_SECONDS - (i - 1)) % PROFILE_SECONDS;
+		printf("profile: second %" PRIu64 "\n", profile.second_start_ns[slot] / NS_PER_SECOND);
+		for (unsigned s = 0 ; s < profile.num_stages ; s++) {
+			const profile_stage_t * const stage = &profile.ring[slot * profile.num_stages + s];
+			if (stage->hist.total == 0)
+				continue;
+			printf("profile:   %-12s %7" PRIu64 " %9.3f ms %6.2f%%  %8" PRIu64 " %8" PRIu64 " %8" PRIu64 "\n",
+				profile.names[s], stage->hist.total, stage->total_ns / 1e6, 100.0 * stage->total_ns / NS_PER_SECOND,
+				hdrhist_percentile(&stage->hist, 0.5), hdrhist_percentile(&stage->hist, 0.99), stage->hist.max);
+		}
+	}
+	fflush(stdout);
+}
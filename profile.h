@@ -0,0 +1,101 @@
+/** \file
+ * Per stage timing of the packet loop.
+ *
+ * Built with `make PROFILE=1` (LEDBURN_PROFILE), PROFILE_START and
+ * PROFILE_END time a stage with CLOCK_MONOTONIC, which the ARM vDSO of
+ * the BeagleBone's 3.8 and 4.x kernels reads without a system call (it
+ * does not serve CLOCK_MONOTONIC_RAW), and record it in the stage's
+ * histogram of the current second, in nanoseconds. The last PROFILE_SECONDS seconds are kept in a ring,
+ * printed on SIGUSR1:
+ *
+ *	kill -USR1 $(pidof led-burn-server)
+ *
+ * Without it the macros are empty, and nothing is timed.
+ *
+ * The Cortex-A8 cycle counter would be cheaper to read, but user space
+ * can only read it once a kernel module enabled it (PMUSERENR).
+ */
+#ifndef _profile_h_
+#define _profile_h_
+
+#include <stdint.h>
+#include <signal.h>
+#include <time.h>
+#include "hdrhist.h"
+
+#define PROFILE_SECONDS 60
+
+typedef struct {
+	hdrhist_t hist; // nanoseconds
+	uint64_t total_ns;
+} profile_stage_t;
+
+typedef struct {
+	const char * const * names;
+	unsigned num_stages;
+	profile_stage_t * ring; // PROFILE_SECONDS seconds of num_stages stages
+	uint64_t * second_start_ns;
+	unsigned current;
+	unsigned filled;
+	uint64_t second_end_ns;
+	volatile sig_atomic_t dump_requested;
+} profile_t;
+
+extern profile_t profile;
+
+
+static inline uint64_t
+profile_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/** Move on to the second of now, clearing the oldest one */
+extern void
+profile_rotate(
+	uint64_t now
+);
+
+static inline void
+profile_record(
+	unsigned stage,
+	uint64_t start_ns
+)
+{
+	const uint64_t now = profile_now();
+	if (now >= profile.second_end_ns)
+		profile_rotate(now);
+	profile_stage_t * const s = &profile.ring[profile.current * profile.num_stages + stage];
+	hdrhist_record(&s->hist, now - start_ns);
+	s->total_ns += now - start_ns;
+}
+
+/** Allocate the ring, and print it on SIGUSR1 */
+extern void
+profile_init(
+	const char * const names[],
+	unsigned num_stages
+);
+
+/** Print the ring if SIGUSR1 asked for it */
+extern void
+profile_poll(void);
+
+extern void
+profile_print(void);
+
+#ifdef LEDBURN_PROFILE
+#define PROFILE_INIT(names, n)		profile_init(names, n)
+#define PROFILE_START(var)		const uint64_t var = profile_now()
+#define PROFILE_END(stage, var)		profile_record(stage, var)
+#define PROFILE_POLL()			profile_poll()
+#else
+#define PROFILE_INIT(names, n)		((void) 0)
+#define PROFILE_START(var)		((void) 0)
+#define PROFILE_END(stage, var)		((void) 0)
+#define PROFILE_POLL()			((void) 0)
+#endif
+
+#endif
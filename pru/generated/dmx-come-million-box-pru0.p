@@ -0,0 +1,3 @@
+#define PRU_NUM 0
+#include "mapping-come-million-box-p.h"
+#include "../templates/dmx.p"
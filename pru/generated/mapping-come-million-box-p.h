@@ -0,0 +1,328 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pin Mapping: come-million-box
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PRU0 Mappings
+// --- Channel 0 ---
+#define pru0_gpio0_bit0 30
+#define pru0_channel0_bank 0
+#define pru0_channel0_bit 30
+#define pru0_channel0_usedBit 0
+
+// --- Channel 1 ---
+#define pru0_gpio0_bit1 31
+#define pru0_channel1_bank 0
+#define pru0_channel1_bit 31
+#define pru0_channel1_usedBit 1
+
+// --- Channel 2 ---
+#define pru0_gpio1_bit0 16
+#define pru0_channel2_bank 1
+#define pru0_channel2_bit 16
+#define pru0_channel2_usedBit 0
+
+// --- Channel 3 ---
+#define pru0_gpio0_bit2 3
+#define pru0_channel3_bank 0
+#define pru0_channel3_bit 3
+#define pru0_channel3_usedBit 2
+
+// --- Channel 4 ---
+#define pru0_gpio1_bit1 17
+#define pru0_channel4_bank 1
+#define pru0_channel4_bit 17
+#define pru0_channel4_usedBit 1
+
+// --- Channel 5 ---
+#define pru0_gpio3_bit0 15
+#define pru0_channel5_bank 3
+#define pru0_channel5_bit 15
+#define pru0_channel5_usedBit 0
+
+// --- Channel 6 ---
+#define pru0_gpio3_bit1 14
+#define pru0_channel6_bank 3
+#define pru0_channel6_bit 14
+#define pru0_channel6_usedBit 1
+
+// --- Channel 7 ---
+#define pru0_gpio0_bit3 20
+#define pru0_channel7_bank 0
+#define pru0_channel7_bit 20
+#define pru0_channel7_usedBit 3
+
+// --- Channel 8 ---
+#define pru0_gpio2_bit0 3
+#define pru0_channel8_bank 2
+#define pru0_channel8_bit 3
+#define pru0_channel8_usedBit 0
+
+// --- Channel 9 ---
+#define pru0_gpio2_bit1 4
+#define pru0_channel9_bank 2
+#define pru0_channel9_bit 4
+#define pru0_channel9_usedBit 1
+
+// --- Channel 10 ---
+#define pru0_gpio1_bit2 12
+#define pru0_channel10_bank 1
+#define pru0_channel10_bit 12
+#define pru0_channel10_usedBit 2
+
+// --- Channel 11 ---
+#define pru0_gpio0_bit4 26
+#define pru0_channel11_bank 0
+#define pru0_channel11_bit 26
+#define pru0_channel11_usedBit 4
+
+// --- Channel 12 ---
+#define pru0_gpio1_bit3 14
+#define pru0_channel12_bank 1
+#define pru0_channel12_bit 14
+#define pru0_channel12_usedBit 3
+
+// --- Channel 13 ---
+#define pru0_gpio2_bit2 1
+#define pru0_channel13_bank 2
+#define pru0_channel13_bit 1
+#define pru0_channel13_usedBit 2
+
+// --- Channel 14 ---
+#define pru0_gpio2_bit3 25
+#define pru0_channel14_bank 2
+#define pru0_channel14_bit 25
+#define pru0_channel14_usedBit 3
+
+// --- Channel 15 ---
+#define pru0_gpio0_bit5 11
+#define pru0_channel15_bank 0
+#define pru0_channel15_bit 11
+#define pru0_channel15_usedBit 5
+
+// --- Channel 16 ---
+#define pru0_gpio0_bit6 10
+#define pru0_channel16_bank 0
+#define pru0_channel16_bit 10
+#define pru0_channel16_usedBit 6
+
+// --- Channel 17 ---
+#define pru0_gpio0_bit7 9
+#define pru0_channel17_bank 0
+#define pru0_channel17_bit 9
+#define pru0_channel17_usedBit 7
+
+// --- Channel 18 ---
+#define pru0_gpio0_bit8 8
+#define pru0_channel18_bank 0
+#define pru0_channel18_bit 8
+#define pru0_channel18_usedBit 8
+
+// --- Channel 19 ---
+#define pru0_gpio2_bit4 14
+#define pru0_channel19_bank 2
+#define pru0_channel19_bit 14
+#define pru0_channel19_usedBit 4
+
+// --- Channel 20 ---
+#define pru0_gpio2_bit5 12
+#define pru0_channel20_bank 2
+#define pru0_channel20_bit 12
+#define pru0_channel20_usedBit 5
+
+// --- Channel 21 ---
+#define pru0_gpio2_bit6 10
+#define pru0_channel21_bank 2
+#define pru0_channel21_bit 10
+#define pru0_channel21_usedBit 6
+
+// --- Channel 22 ---
+#define pru0_gpio2_bit7 8
+#define pru0_channel22_bank 2
+#define pru0_channel22_bit 8
+#define pru0_channel22_usedBit 7
+
+// --- Channel 23 ---
+#define pru0_gpio2_bit8 6
+#define pru0_channel23_bank 2
+#define pru0_channel23_bit 6
+#define pru0_channel23_usedBit 8
+
+
+#define pru0_gpio0_all_mask 0xC4100F08
+#define pru0_gpio0_even_mask 0x40000500
+#define pru0_gpio0_odd_mask 0x84100A08
+#define pru0_gpio1_all_mask 0x00035000
+#define pru0_gpio1_even_mask 0x00035000
+#define pru0_gpio1_odd_mask 0x00000000
+#define pru0_gpio2_all_mask 0x0200555A
+#define pru0_gpio2_even_mask 0x02001108
+#define pru0_gpio2_odd_mask 0x00004452
+#define pru0_gpio3_all_mask 0x0000C000
+#define pru0_gpio3_even_mask 0x00004000
+#define pru0_gpio3_odd_mask 0x00008000
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PRU1 Mappings
+// --- Channel 24 ---
+#define pru1_gpio2_bit0 23
+#define pru1_channel0_bank 2
+#define pru1_channel0_bit 23
+#define pru1_channel0_usedBit 0
+
+// --- Channel 25 ---
+#define pru1_gpio2_bit1 7
+#define pru1_channel1_bank 2
+#define pru1_channel1_bit 7
+#define pru1_channel1_usedBit 1
+
+// --- Channel 26 ---
+#define pru1_gpio2_bit2 9
+#define pru1_channel2_bank 2
+#define pru1_channel2_bit 9
+#define pru1_channel2_usedBit 2
+
+// --- Channel 27 ---
+#define pru1_gpio2_bit3 11
+#define pru1_channel3_bank 2
+#define pru1_channel3_bit 11
+#define pru1_channel3_usedBit 3
+
+// --- Channel 28 ---
+#define pru1_gpio2_bit4 13
+#define pru1_channel4_bank 2
+#define pru1_channel4_bit 13
+#define pru1_channel4_usedBit 4
+
+// --- Channel 29 ---
+#define pru1_gpio2_bit5 15
+#define pru1_channel5_bank 2
+#define pru1_channel5_bit 15
+#define pru1_channel5_usedBit 5
+
+// --- Channel 30 ---
+#define pru1_gpio2_bit6 16
+#define pru1_channel6_bank 2
+#define pru1_channel6_bit 16
+#define pru1_channel6_usedBit 6
+
+// --- Channel 31 ---
+#define pru1_gpio2_bit7 17
+#define pru1_channel7_bank 2
+#define pru1_channel7_bit 17
+#define pru1_channel7_usedBit 7
+
+// --- Channel 32 ---
+#define pru1_gpio1_bit0 28
+#define pru1_channel8_bank 1
+#define pru1_channel8_bit 28
+#define pru1_channel8_usedBit 0
+
+// --- Channel 33 ---
+#define pru1_gpio1_bit1 18
+#define pru1_channel9_bank 1
+#define pru1_channel9_bit 18
+#define pru1_channel9_usedBit 1
+
+// --- Channel 34 ---
+#define pru1_gpio1_bit2 19
+#define pru1_channel10_bank 1
+#define pru1_channel10_bit 19
+#define pru1_channel10_usedBit 2
+
+// --- Channel 35 ---
+#define pru1_gpio0_bit0 2
+#define pru1_channel11_bank 0
+#define pru1_channel11_bit 2
+#define pru1_channel11_usedBit 0
+
+// --- Channel 36 ---
+#define pru1_gpio0_bit1 14
+#define pru1_channel12_bank 0
+#define pru1_channel12_bit 14
+#define pru1_channel12_usedBit 1
+
+// --- Channel 37 ---
+#define pru1_gpio3_bit0 17
+#define pru1_channel13_bank 3
+#define pru1_channel13_bit 17
+#define pru1_channel13_usedBit 0
+
+// --- Channel 38 ---
+#define pru1_gpio3_bit1 16
+#define pru1_channel14_bank 3
+#define pru1_channel14_bit 16
+#define pru1_channel14_usedBit 1
+
+// --- Channel 39 ---
+#define pru1_gpio0_bit2 7
+#define pru1_channel15_bank 0
+#define pru1_channel15_bit 7
+#define pru1_channel15_usedBit 2
+
+// --- Channel 40 ---
+#define pru1_gpio0_bit3 22
+#define pru1_channel16_bank 0
+#define pru1_channel16_bit 22
+#define pru1_channel16_usedBit 3
+
+// --- Channel 41 ---
+#define pru1_gpio2_bit8 22
+#define pru1_channel17_bank 2
+#define pru1_channel17_bit 22
+#define pru1_channel17_usedBit 8
+
+// --- Channel 42 ---
+#define pru1_gpio1_bit3 15
+#define pru1_channel18_bank 1
+#define pru1_channel18_bit 15
+#define pru1_channel18_usedBit 3
+
+// --- Channel 43 ---
+#define pru1_gpio0_bit4 27
+#define pru1_channel19_bank 0
+#define pru1_channel19_bit 27
+#define pru1_channel19_usedBit 4
+
+// --- Channel 44 ---
+#define pru1_gpio1_bit4 13
+#define pru1_channel20_bank 1
+#define pru1_channel20_bit 13
+#define pru1_channel20_usedBit 4
+
+// --- Channel 45 ---
+#define pru1_gpio0_bit5 23
+#define pru1_channel21_bank 0
+#define pru1_channel21_bit 23
+#define pru1_channel21_usedBit 5
+
+// --- Channel 46 ---
+#define pru1_gpio2_bit9 2
+#define pru1_channel22_bank 2
+#define pru1_channel22_bit 2
+#define pru1_channel22_usedBit 9
+
+// --- Channel 47 ---
+#define pru1_gpio2_bit10 5
+#define pru1_channel23_bank 2
+#define pru1_channel23_bit 5
+#define pru1_channel23_usedBit 10
+
+
+#define pru1_gpio0_all_mask 0x08C04084
+#define pru1_gpio0_even_mask 0x00404000
+#define pru1_gpio0_odd_mask 0x08800084
+#define pru1_gpio1_all_mask 0x100CA000
+#define pru1_gpio1_even_mask 0x1008A000
+#define pru1_gpio1_odd_mask 0x00040000
+#define pru1_gpio2_all_mask 0x00C3AAA4
+#define pru1_gpio2_even_mask 0x00812204
+#define pru1_gpio2_odd_mask 0x004288A0
+#define pru1_gpio3_all_mask 0x00030000
+#define pru1_gpio3_even_mask 0x00010000
+#define pru1_gpio3_odd_mask 0x00020000
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,328 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pin Mapping: Original LEDscape
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PRU0 Mappings
+// --- Channel 0 ---
+#define pru0_gpio0_bit0 2
+#define pru0_channel0_bank 0
+#define pru0_channel0_bit 2
+#define pru0_channel0_usedBit 0
+
+// --- Channel 1 ---
+#define pru0_gpio0_bit1 3
+#define pru0_channel1_bank 0
+#define pru0_channel1_bit 3
+#define pru0_channel1_usedBit 1
+
+// --- Channel 2 ---
+#define pru0_gpio0_bit2 7
+#define pru0_channel2_bank 0
+#define pru0_channel2_bit 7
+#define pru0_channel2_usedBit 2
+
+// --- Channel 3 ---
+#define pru0_gpio0_bit3 8
+#define pru0_channel3_bank 0
+#define pru0_channel3_bit 8
+#define pru0_channel3_usedBit 3
+
+// --- Channel 4 ---
+#define pru0_gpio0_bit4 9
+#define pru0_channel4_bank 0
+#define pru0_channel4_bit 9
+#define pru0_channel4_usedBit 4
+
+// --- Channel 5 ---
+#define pru0_gpio0_bit5 10
+#define pru0_channel5_bank 0
+#define pru0_channel5_bit 10
+#define pru0_channel5_usedBit 5
+
+// --- Channel 6 ---
+#define pru0_gpio0_bit6 11
+#define pru0_channel6_bank 0
+#define pru0_channel6_bit 11
+#define pru0_channel6_usedBit 6
+
+// --- Channel 7 ---
+#define pru0_gpio0_bit7 14
+#define pru0_channel7_bank 0
+#define pru0_channel7_bit 14
+#define pru0_channel7_usedBit 7
+
+// --- Channel 8 ---
+#define pru0_gpio0_bit8 20
+#define pru0_channel8_bank 0
+#define pru0_channel8_bit 20
+#define pru0_channel8_usedBit 8
+
+// --- Channel 9 ---
+#define pru0_gpio0_bit9 22
+#define pru0_channel9_bank 0
+#define pru0_channel9_bit 22
+#define pru0_channel9_usedBit 9
+
+// --- Channel 10 ---
+#define pru0_gpio0_bit10 23
+#define pru0_channel10_bank 0
+#define pru0_channel10_bit 23
+#define pru0_channel10_usedBit 10
+
+// --- Channel 11 ---
+#define pru0_gpio0_bit11 26
+#define pru0_channel11_bank 0
+#define pru0_channel11_bit 26
+#define pru0_channel11_usedBit 11
+
+// --- Channel 12 ---
+#define pru0_gpio0_bit12 27
+#define pru0_channel12_bank 0
+#define pru0_channel12_bit 27
+#define pru0_channel12_usedBit 12
+
+// --- Channel 13 ---
+#define pru0_gpio0_bit13 30
+#define pru0_channel13_bank 0
+#define pru0_channel13_bit 30
+#define pru0_channel13_usedBit 13
+
+// --- Channel 14 ---
+#define pru0_gpio0_bit14 31
+#define pru0_channel14_bank 0
+#define pru0_channel14_bit 31
+#define pru0_channel14_usedBit 14
+
+// --- Channel 15 ---
+#define pru0_gpio1_bit0 12
+#define pru0_channel15_bank 1
+#define pru0_channel15_bit 12
+#define pru0_channel15_usedBit 0
+
+// --- Channel 16 ---
+#define pru0_gpio1_bit1 13
+#define pru0_channel16_bank 1
+#define pru0_channel16_bit 13
+#define pru0_channel16_usedBit 1
+
+// --- Channel 17 ---
+#define pru0_gpio1_bit2 14
+#define pru0_channel17_bank 1
+#define pru0_channel17_bit 14
+#define pru0_channel17_usedBit 2
+
+// --- Channel 18 ---
+#define pru0_gpio1_bit3 15
+#define pru0_channel18_bank 1
+#define pru0_channel18_bit 15
+#define pru0_channel18_usedBit 3
+
+// --- Channel 19 ---
+#define pru0_gpio1_bit4 16
+#define pru0_channel19_bank 1
+#define pru0_channel19_bit 16
+#define pru0_channel19_usedBit 4
+
+// --- Channel 20 ---
+#define pru0_gpio1_bit5 17
+#define pru0_channel20_bank 1
+#define pru0_channel20_bit 17
+#define pru0_channel20_usedBit 5
+
+// --- Channel 21 ---
+#define pru0_gpio1_bit6 18
+#define pru0_channel21_bank 1
+#define pru0_channel21_bit 18
+#define pru0_channel21_usedBit 6
+
+// --- Channel 22 ---
+#define pru0_gpio1_bit7 19
+#define pru0_channel22_bank 1
+#define pru0_channel22_bit 19
+#define pru0_channel22_usedBit 7
+
+// --- Channel 23 ---
+#define pru0_gpio1_bit8 28
+#define pru0_channel23_bank 1
+#define pru0_channel23_bit 28
+#define pru0_channel23_usedBit 8
+
+
+#define pru0_gpio0_all_mask 0xCCD04F8C
+#define pru0_gpio0_even_mask 0x88900A84
+#define pru0_gpio0_odd_mask 0x44404508
+#define pru0_gpio1_all_mask 0x100FF000
+#define pru0_gpio1_even_mask 0x000AA000
+#define pru0_gpio1_odd_mask 0x10055000
+#define pru0_gpio2_all_mask 0x00000000
+#define pru0_gpio2_even_mask 0x00000000
+#define pru0_gpio2_odd_mask 0x00000000
+#define pru0_gpio3_all_mask 0x00000000
+#define pru0_gpio3_even_mask 0x00000000
+#define pru0_gpio3_odd_mask 0x00000000
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PRU1 Mappings
+// --- Channel 24 ---
+#define pru1_gpio2_bit0 1
+#define pru1_channel0_bank 2
+#define pru1_channel0_bit 1
+#define pru1_channel0_usedBit 0
+
+// --- Channel 25 ---
+#define pru1_gpio2_bit1 2
+#define pru1_channel1_bank 2
+#define pru1_channel1_bit 2
+#define pru1_channel1_usedBit 1
+
+// --- Channel 26 ---
+#define pru1_gpio2_bit2 3
+#define pru1_channel2_bank 2
+#define pru1_channel2_bit 3
+#define pru1_channel2_usedBit 2
+
+// --- Channel 27 ---
+#define pru1_gpio2_bit3 4
+#define pru1_channel3_bank 2
+#define pru1_channel3_bit 4
+#define pru1_channel3_usedBit 3
+
+// --- Channel 28 ---
+#define pru1_gpio2_bit4 5
+#define pru1_channel4_bank 2
+#define pru1_channel4_bit 5
+#define pru1_channel4_usedBit 4
+
+// --- Channel 29 ---
+#define pru1_gpio2_bit5 6
+#define pru1_channel5_bank 2
+#define pru1_channel5_bit 6
+#define pru1_channel5_usedBit 5
+
+// --- Channel 30 ---
+#define pru1_gpio2_bit6 7
+#define pru1_channel6_bank 2
+#define pru1_channel6_bit 7
+#define pru1_channel6_usedBit 6
+
+// --- Channel 31 ---
+#define pru1_gpio2_bit7 8
+#define pru1_channel7_bank 2
+#define pru1_channel7_bit 8
+#define pru1_channel7_usedBit 7
+
+// --- Channel 32 ---
+#define pru1_gpio2_bit8 9
+#define pru1_channel8_bank 2
+#define pru1_channel8_bit 9
+#define pru1_channel8_usedBit 8
+
+// --- Channel 33 ---
+#define pru1_gpio2_bit9 10
+#define pru1_channel9_bank 2
+#define pru1_channel9_bit 10
+#define pru1_channel9_usedBit 9
+
+// --- Channel 34 ---
+#define pru1_gpio2_bit10 11
+#define pru1_channel10_bank 2
+#define pru1_channel10_bit 11
+#define pru1_channel10_usedBit 10
+
+// --- Channel 35 ---
+#define pru1_gpio2_bit11 12
+#define pru1_channel11_bank 2
+#define pru1_channel11_bit 12
+#define pru1_channel11_usedBit 11
+
+// --- Channel 36 ---
+#define pru1_gpio2_bit12 13
+#define pru1_channel12_bank 2
+#define pru1_channel12_bit 13
+#define pru1_channel12_usedBit 12
+
+// --- Channel 37 ---
+#define pru1_gpio2_bit13 14
+#define pru1_channel13_bank 2
+#define pru1_channel13_bit 14
+#define pru1_channel13_usedBit 13
+
+// --- Channel 38 ---
+#define pru1_gpio2_bit14 15
+#define pru1_channel14_bank 2
+#define pru1_channel14_bit 15
+#define pru1_channel14_usedBit 14
+
+// --- Channel 39 ---
+#define pru1_gpio2_bit15 16
+#define pru1_channel15_bank 2
+#define pru1_channel15_bit 16
+#define pru1_channel15_usedBit 15
+
+// --- Channel 40 ---
+#define pru1_gpio2_bit16 17
+#define pru1_channel16_bank 2
+#define pru1_channel16_bit 17
+#define pru1_channel16_usedBit 16
+
+// --- Channel 41 ---
+#define pru1_gpio2_bit17 22
+#define pru1_channel17_bank 2
+#define pru1_channel17_bit 22
+#define pru1_channel17_usedBit 17
+
+// --- Channel 42 ---
+#define pru1_gpio2_bit18 23
+#define pru1_channel18_bank 2
+#define pru1_channel18_bit 23
+#define pru1_channel18_usedBit 18
+
+// --- Channel 43 ---
+#define pru1_gpio2_bit19 25
+#define pru1_channel19_bank 2
+#define pru1_channel19_bit 25
+#define pru1_channel19_usedBit 19
+
+// --- Channel 44 ---
+#define pru1_gpio3_bit0 14
+#define pru1_channel20_bank 3
+#define pru1_channel20_bit 14
+#define pru1_channel20_usedBit 0
+
+// --- Channel 45 ---
+#define pru1_gpio3_bit1 15
+#define pru1_channel21_bank 3
+#define pru1_channel21_bit 15
+#define pru1_channel21_usedBit 1
+
+// --- Channel 46 ---
+#define pru1_gpio3_bit2 16
+#define pru1_channel22_bank 3
+#define pru1_channel22_bit 16
+#define pru1_channel22_usedBit 2
+
+// --- Channel 47 ---
+#define pru1_gpio3_bit3 17
+#define pru1_channel23_bank 3
+#define pru1_channel23_bit 17
+#define pru1_channel23_usedBit 3
+
+
+#define pru1_gpio0_all_mask 0x00000000
+#define pru1_gpio0_even_mask 0x00000000
+#define pru1_gpio0_odd_mask 0x00000000
+#define pru1_gpio1_all_mask 0x00000000
+#define pru1_gpio1_even_mask 0x00000000
+#define pru1_gpio1_odd_mask 0x00000000
+#define pru1_gpio2_all_mask 0x02C3FFFE
+#define pru1_gpio2_even_mask 0x0082AAAA
+#define pru1_gpio2_odd_mask 0x02415554
+#define pru1_gpio3_all_mask 0x0003C000
+#define pru1_gpio3_even_mask 0x00014000
+#define pru1_gpio3_odd_mask 0x00028000
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,328 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pin Mapping: RGB-123 v2
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PRU0 Mappings
+// --- Channel 0 ---
+#define pru0_gpio0_bit0 11
+#define pru0_channel0_bank 0
+#define pru0_channel0_bit 11
+#define pru0_channel0_usedBit 0
+
+// --- Channel 1 ---
+#define pru0_gpio2_bit0 25
+#define pru0_channel1_bank 2
+#define pru0_channel1_bit 25
+#define pru0_channel1_usedBit 0
+
+// --- Channel 2 ---
+#define pru0_gpio2_bit1 1
+#define pru0_channel2_bank 2
+#define pru0_channel2_bit 1
+#define pru0_channel2_usedBit 1
+
+// --- Channel 3 ---
+#define pru0_gpio1_bit0 14
+#define pru0_channel3_bank 1
+#define pru0_channel3_bit 14
+#define pru0_channel3_usedBit 0
+
+// --- Channel 4 ---
+#define pru0_gpio0_bit1 26
+#define pru0_channel4_bank 0
+#define pru0_channel4_bit 26
+#define pru0_channel4_usedBit 1
+
+// --- Channel 5 ---
+#define pru0_gpio1_bit1 12
+#define pru0_channel5_bank 1
+#define pru0_channel5_bit 12
+#define pru0_channel5_usedBit 1
+
+// --- Channel 6 ---
+#define pru0_gpio2_bit2 4
+#define pru0_channel6_bank 2
+#define pru0_channel6_bit 4
+#define pru0_channel6_usedBit 2
+
+// --- Channel 7 ---
+#define pru0_gpio2_bit3 3
+#define pru0_channel7_bank 2
+#define pru0_channel7_bit 3
+#define pru0_channel7_usedBit 3
+
+// --- Channel 8 ---
+#define pru0_gpio2_bit4 6
+#define pru0_channel8_bank 2
+#define pru0_channel8_bit 6
+#define pru0_channel8_usedBit 4
+
+// --- Channel 9 ---
+#define pru0_gpio2_bit5 7
+#define pru0_channel9_bank 2
+#define pru0_channel9_bit 7
+#define pru0_channel9_usedBit 5
+
+// --- Channel 10 ---
+#define pru0_gpio2_bit6 9
+#define pru0_channel10_bank 2
+#define pru0_channel10_bit 9
+#define pru0_channel10_usedBit 6
+
+// --- Channel 11 ---
+#define pru0_gpio2_bit7 11
+#define pru0_channel11_bank 2
+#define pru0_channel11_bit 11
+#define pru0_channel11_usedBit 7
+
+// --- Channel 12 ---
+#define pru0_gpio2_bit8 13
+#define pru0_channel12_bank 2
+#define pru0_channel12_bit 13
+#define pru0_channel12_usedBit 8
+
+// --- Channel 13 ---
+#define pru0_gpio2_bit9 15
+#define pru0_channel13_bank 2
+#define pru0_channel13_bit 15
+#define pru0_channel13_usedBit 9
+
+// --- Channel 14 ---
+#define pru0_gpio2_bit10 16
+#define pru0_channel14_bank 2
+#define pru0_channel14_bit 16
+#define pru0_channel14_usedBit 10
+
+// --- Channel 15 ---
+#define pru0_gpio2_bit11 17
+#define pru0_channel15_bank 2
+#define pru0_channel15_bit 17
+#define pru0_channel15_usedBit 11
+
+// --- Channel 16 ---
+#define pru0_gpio2_bit12 23
+#define pru0_channel16_bank 2
+#define pru0_channel16_bit 23
+#define pru0_channel16_usedBit 12
+
+// --- Channel 17 ---
+#define pru0_gpio0_bit2 10
+#define pru0_channel17_bank 0
+#define pru0_channel17_bit 10
+#define pru0_channel17_usedBit 2
+
+// --- Channel 18 ---
+#define pru0_gpio0_bit3 9
+#define pru0_channel18_bank 0
+#define pru0_channel18_bit 9
+#define pru0_channel18_usedBit 3
+
+// --- Channel 19 ---
+#define pru0_gpio0_bit4 8
+#define pru0_channel19_bank 0
+#define pru0_channel19_bit 8
+#define pru0_channel19_usedBit 4
+
+// --- Channel 20 ---
+#define pru0_gpio2_bit13 14
+#define pru0_channel20_bank 2
+#define pru0_channel20_bit 14
+#define pru0_channel20_usedBit 13
+
+// --- Channel 21 ---
+#define pru0_gpio2_bit14 12
+#define pru0_channel21_bank 2
+#define pru0_channel21_bit 12
+#define pru0_channel21_usedBit 14
+
+// --- Channel 22 ---
+#define pru0_gpio2_bit15 10
+#define pru0_channel22_bank 2
+#define pru0_channel22_bit 10
+#define pru0_channel22_usedBit 15
+
+// --- Channel 23 ---
+#define pru0_gpio2_bit16 8
+#define pru0_channel23_bank 2
+#define pru0_channel23_bit 8
+#define pru0_channel23_usedBit 16
+
+
+#define pru0_gpio0_all_mask 0x04000F00
+#define pru0_gpio0_even_mask 0x04000A00
+#define pru0_gpio0_odd_mask 0x00000500
+#define pru0_gpio1_all_mask 0x00005000
+#define pru0_gpio1_even_mask 0x00000000
+#define pru0_gpio1_odd_mask 0x00005000
+#define pru0_gpio2_all_mask 0x0283FFDA
+#define pru0_gpio2_even_mask 0x00816652
+#define pru0_gpio2_odd_mask 0x02029988
+#define pru0_gpio3_all_mask 0x00000000
+#define pru0_gpio3_even_mask 0x00000000
+#define pru0_gpio3_odd_mask 0x00000000
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PRU1 Mappings
+// --- Channel 24 ---
+#define pru1_gpio2_bit0 2
+#define pru1_channel0_bank 2
+#define pru1_channel0_bit 2
+#define pru1_channel0_usedBit 0
+
+// --- Channel 25 ---
+#define pru1_gpio2_bit1 5
+#define pru1_channel1_bank 2
+#define pru1_channel1_bit 5
+#define pru1_channel1_usedBit 1
+
+// --- Channel 26 ---
+#define pru1_gpio1_bit0 13
+#define pru1_channel2_bank 1
+#define pru1_channel2_bit 13
+#define pru1_channel2_usedBit 0
+
+// --- Channel 27 ---
+#define pru1_gpio0_bit0 23
+#define pru1_channel3_bank 0
+#define pru1_channel3_bit 23
+#define pru1_channel3_usedBit 0
+
+// --- Channel 28 ---
+#define pru1_gpio1_bit1 15
+#define pru1_channel4_bank 1
+#define pru1_channel4_bit 15
+#define pru1_channel4_usedBit 1
+
+// --- Channel 29 ---
+#define pru1_gpio0_bit1 27
+#define pru1_channel5_bank 0
+#define pru1_channel5_bit 27
+#define pru1_channel5_usedBit 1
+
+// --- Channel 30 ---
+#define pru1_gpio0_bit2 22
+#define pru1_channel6_bank 0
+#define pru1_channel6_bit 22
+#define pru1_channel6_usedBit 2
+
+// --- Channel 31 ---
+#define pru1_gpio2_bit2 22
+#define pru1_channel7_bank 2
+#define pru1_channel7_bit 22
+#define pru1_channel7_usedBit 2
+
+// --- Channel 32 ---
+#define pru1_gpio1_bit2 17
+#define pru1_channel8_bank 1
+#define pru1_channel8_bit 17
+#define pru1_channel8_usedBit 2
+
+// --- Channel 33 ---
+#define pru1_gpio0_bit3 14
+#define pru1_channel9_bank 0
+#define pru1_channel9_bit 14
+#define pru1_channel9_usedBit 3
+
+// --- Channel 34 ---
+#define pru1_gpio3_bit0 17
+#define pru1_channel10_bank 3
+#define pru1_channel10_bit 17
+#define pru1_channel10_usedBit 0
+
+// --- Channel 35 ---
+#define pru1_gpio3_bit1 15
+#define pru1_channel11_bank 3
+#define pru1_channel11_bit 15
+#define pru1_channel11_usedBit 1
+
+// --- Channel 36 ---
+#define pru1_gpio3_bit2 16
+#define pru1_channel12_bank 3
+#define pru1_channel12_bit 16
+#define pru1_channel12_usedBit 2
+
+// --- Channel 37 ---
+#define pru1_gpio3_bit3 14
+#define pru1_channel13_bank 3
+#define pru1_channel13_bit 14
+#define pru1_channel13_usedBit 3
+
+// --- Channel 38 ---
+#define pru1_gpio0_bit4 20
+#define pru1_channel14_bank 0
+#define pru1_channel14_bit 20
+#define pru1_channel14_usedBit 4
+
+// --- Channel 39 ---
+#define pru1_gpio0_bit5 7
+#define pru1_channel15_bank 0
+#define pru1_channel15_bit 7
+#define pru1_channel15_usedBit 5
+
+// --- Channel 40 ---
+#define pru1_gpio0_bit6 30
+#define pru1_channel16_bank 0
+#define pru1_channel16_bit 30
+#define pru1_channel16_usedBit 6
+
+// --- Channel 41 ---
+#define pru1_gpio1_bit3 28
+#define pru1_channel17_bank 1
+#define pru1_channel17_bit 28
+#define pru1_channel17_usedBit 3
+
+// --- Channel 42 ---
+#define pru1_gpio0_bit7 31
+#define pru1_channel18_bank 0
+#define pru1_channel18_bit 31
+#define pru1_channel18_usedBit 7
+
+// --- Channel 43 ---
+#define pru1_gpio1_bit4 18
+#define pru1_channel19_bank 1
+#define pru1_channel19_bit 18
+#define pru1_channel19_usedBit 4
+
+// --- Channel 44 ---
+#define pru1_gpio1_bit5 16
+#define pru1_channel20_bank 1
+#define pru1_channel20_bit 16
+#define pru1_channel20_usedBit 5
+
+// --- Channel 45 ---
+#define pru1_gpio1_bit6 19
+#define pru1_channel21_bank 1
+#define pru1_channel21_bit 19
+#define pru1_channel21_usedBit 6
+
+// --- Channel 46 ---
+#define pru1_gpio0_bit8 3
+#define pru1_channel22_bank 0
+#define pru1_channel22_bit 3
+#define pru1_channel22_usedBit 8
+
+// --- Channel 47 ---
+#define pru1_gpio0_bit9 2
+#define pru1_channel23_bank 0
+#define pru1_channel23_bit 2
+#define pru1_channel23_usedBit 9
+
+
+#define pru1_gpio0_all_mask 0xC8D0408C
+#define pru1_gpio0_even_mask 0xC0500008
+#define pru1_gpio0_odd_mask 0x08804084
+#define pru1_gpio1_all_mask 0x100FA000
+#define pru1_gpio1_even_mask 0x0003A000
+#define pru1_gpio1_odd_mask 0x100C0000
+#define pru1_gpio2_all_mask 0x00400024
+#define pru1_gpio2_even_mask 0x00000004
+#define pru1_gpio2_odd_mask 0x00400020
+#define pru1_gpio3_all_mask 0x0003C000
+#define pru1_gpio3_even_mask 0x00030000
+#define pru1_gpio3_odd_mask 0x0000C000
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
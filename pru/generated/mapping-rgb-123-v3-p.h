@@ -0,0 +1,328 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pin Mapping: RGB-123 v3
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PRU0 Mappings
+// --- Channel 0 ---
+#define pru0_gpio2_bit0 3
+#define pru0_channel0_bank 2
+#define pru0_channel0_bit 3
+#define pru0_channel0_usedBit 0
+
+// --- Channel 1 ---
+#define pru0_gpio2_bit1 4
+#define pru0_channel1_bank 2
+#define pru0_channel1_bit 4
+#define pru0_channel1_usedBit 1
+
+// --- Channel 2 ---
+#define pru0_gpio1_bit0 12
+#define pru0_channel2_bank 1
+#define pru0_channel2_bit 12
+#define pru0_channel2_usedBit 0
+
+// --- Channel 3 ---
+#define pru0_gpio0_bit0 26
+#define pru0_channel3_bank 0
+#define pru0_channel3_bit 26
+#define pru0_channel3_usedBit 0
+
+// --- Channel 4 ---
+#define pru0_gpio1_bit1 14
+#define pru0_channel4_bank 1
+#define pru0_channel4_bit 14
+#define pru0_channel4_usedBit 1
+
+// --- Channel 5 ---
+#define pru0_gpio2_bit2 1
+#define pru0_channel5_bank 2
+#define pru0_channel5_bit 1
+#define pru0_channel5_usedBit 2
+
+// --- Channel 6 ---
+#define pru0_gpio2_bit3 25
+#define pru0_channel6_bank 2
+#define pru0_channel6_bit 25
+#define pru0_channel6_usedBit 3
+
+// --- Channel 7 ---
+#define pru0_gpio0_bit1 11
+#define pru0_channel7_bank 0
+#define pru0_channel7_bit 11
+#define pru0_channel7_usedBit 1
+
+// --- Channel 8 ---
+#define pru0_gpio2_bit4 17
+#define pru0_channel8_bank 2
+#define pru0_channel8_bit 17
+#define pru0_channel8_usedBit 4
+
+// --- Channel 9 ---
+#define pru0_gpio2_bit5 16
+#define pru0_channel9_bank 2
+#define pru0_channel9_bit 16
+#define pru0_channel9_usedBit 5
+
+// --- Channel 10 ---
+#define pru0_gpio2_bit6 15
+#define pru0_channel10_bank 2
+#define pru0_channel10_bit 15
+#define pru0_channel10_usedBit 6
+
+// --- Channel 11 ---
+#define pru0_gpio2_bit7 13
+#define pru0_channel11_bank 2
+#define pru0_channel11_bit 13
+#define pru0_channel11_usedBit 7
+
+// --- Channel 12 ---
+#define pru0_gpio2_bit8 11
+#define pru0_channel12_bank 2
+#define pru0_channel12_bit 11
+#define pru0_channel12_usedBit 8
+
+// --- Channel 13 ---
+#define pru0_gpio2_bit9 9
+#define pru0_channel13_bank 2
+#define pru0_channel13_bit 9
+#define pru0_channel13_usedBit 9
+
+// --- Channel 14 ---
+#define pru0_gpio2_bit10 7
+#define pru0_channel14_bank 2
+#define pru0_channel14_bit 7
+#define pru0_channel14_usedBit 10
+
+// --- Channel 15 ---
+#define pru0_gpio2_bit11 6
+#define pru0_channel15_bank 2
+#define pru0_channel15_bit 6
+#define pru0_channel15_usedBit 11
+
+// --- Channel 16 ---
+#define pru0_gpio2_bit12 8
+#define pru0_channel16_bank 2
+#define pru0_channel16_bit 8
+#define pru0_channel16_usedBit 12
+
+// --- Channel 17 ---
+#define pru0_gpio2_bit13 10
+#define pru0_channel17_bank 2
+#define pru0_channel17_bit 10
+#define pru0_channel17_usedBit 13
+
+// --- Channel 18 ---
+#define pru0_gpio2_bit14 12
+#define pru0_channel18_bank 2
+#define pru0_channel18_bit 12
+#define pru0_channel18_usedBit 14
+
+// --- Channel 19 ---
+#define pru0_gpio2_bit15 14
+#define pru0_channel19_bank 2
+#define pru0_channel19_bit 14
+#define pru0_channel19_usedBit 15
+
+// --- Channel 20 ---
+#define pru0_gpio0_bit2 8
+#define pru0_channel20_bank 0
+#define pru0_channel20_bit 8
+#define pru0_channel20_usedBit 2
+
+// --- Channel 21 ---
+#define pru0_gpio0_bit3 9
+#define pru0_channel21_bank 0
+#define pru0_channel21_bit 9
+#define pru0_channel21_usedBit 3
+
+// --- Channel 22 ---
+#define pru0_gpio0_bit4 10
+#define pru0_channel22_bank 0
+#define pru0_channel22_bit 10
+#define pru0_channel22_usedBit 4
+
+// --- Channel 23 ---
+#define pru0_gpio2_bit16 23
+#define pru0_channel23_bank 2
+#define pru0_channel23_bit 23
+#define pru0_channel23_usedBit 16
+
+
+#define pru0_gpio0_all_mask 0x04000F00
+#define pru0_gpio0_even_mask 0x00000500
+#define pru0_gpio0_odd_mask 0x04000A00
+#define pru0_gpio1_all_mask 0x00005000
+#define pru0_gpio1_even_mask 0x00005000
+#define pru0_gpio1_odd_mask 0x00000000
+#define pru0_gpio2_all_mask 0x0283FFDA
+#define pru0_gpio2_even_mask 0x02029988
+#define pru0_gpio2_odd_mask 0x00816652
+#define pru0_gpio3_all_mask 0x00000000
+#define pru0_gpio3_even_mask 0x00000000
+#define pru0_gpio3_odd_mask 0x00000000
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PRU1 Mappings
+// --- Channel 24 ---
+#define pru1_gpio2_bit0 22
+#define pru1_channel0_bank 2
+#define pru1_channel0_bit 22
+#define pru1_channel0_usedBit 0
+
+// --- Channel 25 ---
+#define pru1_gpio0_bit0 22
+#define pru1_channel1_bank 0
+#define pru1_channel1_bit 22
+#define pru1_channel1_usedBit 0
+
+// --- Channel 26 ---
+#define pru1_gpio0_bit1 27
+#define pru1_channel2_bank 0
+#define pru1_channel2_bit 27
+#define pru1_channel2_usedBit 1
+
+// --- Channel 27 ---
+#define pru1_gpio1_bit0 15
+#define pru1_channel3_bank 1
+#define pru1_channel3_bit 15
+#define pru1_channel3_usedBit 0
+
+// --- Channel 28 ---
+#define pru1_gpio0_bit2 23
+#define pru1_channel4_bank 0
+#define pru1_channel4_bit 23
+#define pru1_channel4_usedBit 2
+
+// --- Channel 29 ---
+#define pru1_gpio1_bit1 13
+#define pru1_channel5_bank 1
+#define pru1_channel5_bit 13
+#define pru1_channel5_usedBit 1
+
+// --- Channel 30 ---
+#define pru1_gpio2_bit1 5
+#define pru1_channel6_bank 2
+#define pru1_channel6_bit 5
+#define pru1_channel6_usedBit 1
+
+// --- Channel 31 ---
+#define pru1_gpio2_bit2 2
+#define pru1_channel7_bank 2
+#define pru1_channel7_bit 2
+#define pru1_channel7_usedBit 2
+
+// --- Channel 32 ---
+#define pru1_gpio1_bit2 28
+#define pru1_channel8_bank 1
+#define pru1_channel8_bit 28
+#define pru1_channel8_usedBit 2
+
+// --- Channel 33 ---
+#define pru1_gpio1_bit3 18
+#define pru1_channel9_bank 1
+#define pru1_channel9_bit 18
+#define pru1_channel9_usedBit 3
+
+// --- Channel 34 ---
+#define pru1_gpio1_bit4 19
+#define pru1_channel10_bank 1
+#define pru1_channel10_bit 19
+#define pru1_channel10_usedBit 4
+
+// --- Channel 35 ---
+#define pru1_gpio0_bit3 2
+#define pru1_channel11_bank 0
+#define pru1_channel11_bit 2
+#define pru1_channel11_usedBit 3
+
+// --- Channel 36 ---
+#define pru1_gpio0_bit4 14
+#define pru1_channel12_bank 0
+#define pru1_channel12_bit 14
+#define pru1_channel12_usedBit 4
+
+// --- Channel 37 ---
+#define pru1_gpio3_bit0 17
+#define pru1_channel13_bank 3
+#define pru1_channel13_bit 17
+#define pru1_channel13_usedBit 0
+
+// --- Channel 38 ---
+#define pru1_gpio3_bit1 16
+#define pru1_channel14_bank 3
+#define pru1_channel14_bit 16
+#define pru1_channel14_usedBit 1
+
+// --- Channel 39 ---
+#define pru1_gpio0_bit5 7
+#define pru1_channel15_bank 0
+#define pru1_channel15_bit 7
+#define pru1_channel15_usedBit 5
+
+// --- Channel 40 ---
+#define pru1_gpio0_bit6 20
+#define pru1_channel16_bank 0
+#define pru1_channel16_bit 20
+#define pru1_channel16_usedBit 6
+
+// --- Channel 41 ---
+#define pru1_gpio3_bit2 14
+#define pru1_channel17_bank 3
+#define pru1_channel17_bit 14
+#define pru1_channel17_usedBit 2
+
+// --- Channel 42 ---
+#define pru1_gpio3_bit3 15
+#define pru1_channel18_bank 3
+#define pru1_channel18_bit 15
+#define pru1_channel18_usedBit 3
+
+// --- Channel 43 ---
+#define pru1_gpio1_bit5 17
+#define pru1_channel19_bank 1
+#define pru1_channel19_bit 17
+#define pru1_channel19_usedBit 5
+
+// --- Channel 44 ---
+#define pru1_gpio0_bit7 3
+#define pru1_channel20_bank 0
+#define pru1_channel20_bit 3
+#define pru1_channel20_usedBit 7
+
+// --- Channel 45 ---
+#define pru1_gpio1_bit6 16
+#define pru1_channel21_bank 1
+#define pru1_channel21_bit 16
+#define pru1_channel21_usedBit 6
+
+// --- Channel 46 ---
+#define pru1_gpio0_bit8 31
+#define pru1_channel22_bank 0
+#define pru1_channel22_bit 31
+#define pru1_channel22_usedBit 8
+
+// --- Channel 47 ---
+#define pru1_gpio0_bit9 30
+#define pru1_channel23_bank 0
+#define pru1_channel23_bit 30
+#define pru1_channel23_usedBit 9
+
+
+#define pru1_gpio0_all_mask 0xC8D0408C
+#define pru1_gpio0_even_mask 0x88904008
+#define pru1_gpio0_odd_mask 0x40400084
+#define pru1_gpio1_all_mask 0x100FA000
+#define pru1_gpio1_even_mask 0x10080000
+#define pru1_gpio1_odd_mask 0x0007A000
+#define pru1_gpio2_all_mask 0x00400024
+#define pru1_gpio2_even_mask 0x00400020
+#define pru1_gpio2_odd_mask 0x00000004
+#define pru1_gpio3_all_mask 0x0003C000
+#define pru1_gpio3_even_mask 0x00018000
+#define pru1_gpio3_odd_mask 0x00024000
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
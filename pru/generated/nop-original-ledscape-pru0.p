@@ -0,0 +1,3 @@
+#define PRU_NUM 0
+#include "mapping-original-ledscape-p.h"
+#include "../templates/nop.p"
@@ -0,0 +1,3 @@
+#define PRU_NUM 0
+#include "mapping-rgb-123-v3-p.h"
+#include "../templates/nop.p"
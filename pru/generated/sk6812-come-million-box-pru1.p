@@ -0,0 +1,3 @@
+#define PRU_NUM 1
+#include "mapping-come-million-box-p.h"
+#include "../templates/sk6812.p"
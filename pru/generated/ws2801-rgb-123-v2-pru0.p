@@ -0,0 +1,3 @@
+#define PRU_NUM 0
+#include "mapping-rgb-123-v2-p.h"
+#include "../templates/ws2801.p"
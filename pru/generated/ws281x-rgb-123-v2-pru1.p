@@ -0,0 +1,3 @@
+#define PRU_NUM 1
+#include "mapping-rgb-123-v2-p.h"
+#include "../templates/ws281x.p"
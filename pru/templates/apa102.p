@@ -11,6 +11,9 @@
 // [ start frame ][   LED1   ][   LED2   ]...[   LEDN   ][ end frame ]
 // [ 32bit x 0   ][0xFF 8 8 8][0xFF 8 8 8]...[0xFF 8 8 8][ (n/2) * 1 ]
 //
+// rows of pixels are r_row_stride bytes apart, and only the first r_num_channels
+// strips of this PRU are read from memory, the others are sent black.
+//
 
 // Mapping lookup
 
@@ -78,12 +81,16 @@ _LOOP:
 	// Command of 0xFF is the signal to exit
 	QBEQ EXIT, r2, #0xFF
 
+	// Load the number of bytes per pixel row and the number of channels
+	// this PRU drives, which depend on how many strips are in use
+	LBCO r_row_info, CONST_PRUDRAM, 16, 4
+
+	// Nothing to clock out if all the strips in use belong to the other PRU
+	QBEQ FRAME_DONE, r_num_channels, 0
+
 // send the start frame
 l_start_frame:
 	MOV r_bit_num, 32
-	
-	// store number of leds in r29
-	MOV r29, r_data_len
 
 	RESET_GPIO_ONES()
 
@@ -141,9 +148,21 @@ l_word_loop:
 		RESET_GPIO_ONES()
 
 		///////////////////////////////////////////////////////////////////////
-		// Load 12 registers of data into r10-r21
-
+		// Load 4, 8 or 12 registers of data into r10-r21.
+		// Registers of channels that are not in use are zeroed, so
+		// those strips are sent black and we only read the bytes we need
+
+		QBLT l_load_12_channels, r_num_channels, 8
+		ZERO &r_data4, 32
+		QBLT l_load_8_channels, r_num_channels, 4
+		LOAD_CHANNEL_DATA(12, 0, 4)
+		QBA l_channels_loaded
+	l_load_8_channels:
+		LOAD_CHANNEL_DATA(12, 0, 8)
+		QBA l_channels_loaded
+	l_load_12_channels:
 		LOAD_CHANNEL_DATA(12, 0, 12)
+	l_channels_loaded:
 
 		// Test for ones
 		TEST_BIT_ONE(r_data0,  0)
@@ -192,14 +211,14 @@ l_word_loop:
 
 	// The RGB streams have been clocked out
 	// Move to the next pixel on each row
-	ADD r_data_addr, r_data_addr, 48 * 4
+	ADD r_data_addr, r_data_addr, r_row_stride
 	DECREMENT r_data_len
 	QBNE l_word_loop, r_data_len, #0
 	
 
 l_end_frame:
-	// send end frame bits
-	MOV r_bit_num, r29
+	// send end frame bits, reloading the number of leds
+	LBCO r_bit_num, CONST_PRUDRAM, 4, 4
 	LSR r_bit_num, r_bit_num, 1
 	ADD r_bit_num, r_bit_num, 1
 
@@ -232,7 +251,7 @@ l_end_frame:
 	PREP_GPIO_MASK_NAMED(all)
 	GPIO_APPLY_MASK_TO_ADDR()
 
-
+FRAME_DONE:
 	// Write out that we are done!
 	// Store a non-zero response in the buffer so that they know that we are done
 	// aso a quick hack, we write the counter so that we know how
@@ -55,6 +55,11 @@
 
 #define r_temp2 r28
 
+// Loaded from the command at the start of every frame
+#define r_row_info r29
+#define r_row_stride r29.w0
+#define r_num_channels r29.w2
+
 // ***************************************
 // *      Global Macro definitions       *
 // ***************************************
@@ -14,6 +14,9 @@
 //
 // each pixel is stored in 4 bytes in the order GRBA (4th byte is ignored)
 //
+// rows of pixels are r_row_stride bytes apart, and only the first r_num_channels
+// strips of this PRU are read from memory, the others are sent zeros.
+//
 // while len > 0:
 //    for bit# = 23 down to 0:
 //        write out bits
@@ -89,6 +92,13 @@ _LOOP:
 	// Command of 0xFF is the signal to exit
 	QBEQ EXIT, r2, #0xFF
 
+	// Load the number of bytes per pixel row and the number of channels
+	// this PRU drives, which depend on how many strips are in use
+	LBCO r_row_info, CONST_PRUDRAM, 16, 4
+
+	// Nothing to clock out if all the strips in use belong to the other PRU
+	QBEQ FRAME_DONE, r_num_channels, 0
+
 	////////////////
 	// PREAMBLE
 
@@ -129,7 +139,16 @@ l_word_loop:
 
 		///////////////////////////////////////////////////////////////////////
 		// LOAD/BUILD DATA MASK
+		// Load 8 or 16 registers of data, starting at r10.
+		// Registers of channels that are not in use are zeroed, so
+		// those outputs send zeros and we only read the bytes we need
+		QBLT l_load_16_channels, r_num_channels, 8
+		LOAD_CHANNEL_DATA(24, 0, 8)
+		ZERO &r_data8, 32
+		QBA l_first_channels_loaded
+	l_load_16_channels:
 		LOAD_CHANNEL_DATA(24, 0, 16)
+	l_first_channels_loaded:
 
 		TEST_BIT_ZERO(r_data0,  0)
 		TEST_BIT_ZERO(r_data1,  1)
@@ -148,7 +167,13 @@ l_word_loop:
 		TEST_BIT_ZERO(r_data14, 14)
 		TEST_BIT_ZERO(r_data15, 15)
 
+		// Load 8 more registers of data, if this PRU drives that many channels
+		QBGE l_zero_last_channels, r_num_channels, 16
 		LOAD_CHANNEL_DATA(24, 16, 8)
+		QBA l_last_channels_loaded
+	l_zero_last_channels:
+		ZERO &r_data0, 32
+	l_last_channels_loaded:
 
 		TEST_BIT_ZERO(r_data0, 16)
 		TEST_BIT_ZERO(r_data1, 17)
@@ -258,10 +283,11 @@ l_word_loop:
 
 	// The RGB streams have been clocked out
 	// Move to the next pixel on each row
-	ADD r_data_addr, r_data_addr, 48 * 4
+	ADD r_data_addr, r_data_addr, r_row_stride
 	DECREMENT r_data_len
 	QBNE l_word_loop, r_data_len, #0
 
+FRAME_DONE:
 	// Write the trailing high
 	PREP_GPIO_MASK_NAMED(all)
 	PREP_GPIO_ADDRS_FOR_SET()
@@ -0,0 +1,15 @@
+// SK6812 RGBW Signal Generation PRU Program Template
+//
+// SK6812 RGBW strips use the ws281x signal but take 32 bits per pixel and need a
+// longer reset time to latch. Each ledscape pixel is clocked out MSB first, so the
+// "unused" byte goes out first, followed by c, b and a:
+//
+//    [ unused ][   c    ][   b    ][   a    ]
+//    [ 8 bits ][ 8 bits ][ 8 bits ][ 8 bits ]
+//
+// Everything else (timing, mappings, command structure) is shared with ws281x.p
+
+#define WS281X_BITS_PER_PIXEL 32
+#define WS281X_RESET_NS 80000
+
+#include "ws281x.p"
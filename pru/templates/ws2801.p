@@ -14,6 +14,9 @@
 //
 // each pixel is stored in 4 bytes in the order GRBA (4th byte is ignored)
 //
+// rows of pixels are r_row_stride bytes apart, and only the first r_num_channels
+// strips of this PRU are read from memory, the others are sent black.
+//
 // while len > 0:
 //    for bit# = 23 down to 0:
 //        write out bits
@@ -89,6 +92,13 @@ _LOOP:
 	// Command of 0xFF is the signal to exit
 	QBEQ EXIT, r2, #0xFF
 
+	// Load the number of bytes per pixel row and the number of channels
+	// this PRU drives, which depend on how many strips are in use
+	LBCO r_row_info, CONST_PRUDRAM, 16, 4
+
+	// Nothing to clock out if all the strips in use belong to the other PRU
+	QBEQ FRAME_DONE, r_num_channels, 0
+
 l_word_loop:
 	// for bit in 24 to 0
 	MOV r_bit_num, 24
@@ -100,9 +110,21 @@ l_word_loop:
 		RESET_GPIO_ONES()
 
 		///////////////////////////////////////////////////////////////////////
-		// Load 12 registers of data into r10-r21
-
+		// Load 4, 8 or 12 registers of data into r10-r21.
+		// Registers of channels that are not in use are zeroed, so
+		// those strips are sent black and we only read the bytes we need
+
+		QBLT l_load_12_channels, r_num_channels, 8
+		ZERO &r_data4, 32
+		QBLT l_load_8_channels, r_num_channels, 4
+		LOAD_CHANNEL_DATA(12, 0, 4)
+		QBA l_channels_loaded
+	l_load_8_channels:
+		LOAD_CHANNEL_DATA(12, 0, 8)
+		QBA l_channels_loaded
+	l_load_12_channels:
 		LOAD_CHANNEL_DATA(12, 0, 12)
+	l_channels_loaded:
 
 		// Test for ones
 		TEST_BIT_ONE(r_data0,  0)
@@ -146,10 +168,11 @@ l_word_loop:
 
 	// The RGB streams have been clocked out
 	// Move to the next pixel on each row
-	ADD r_data_addr, r_data_addr, 48 * 4
+	ADD r_data_addr, r_data_addr, r_row_stride
 	DECREMENT r_data_len
 	QBNE l_word_loop, r_data_len, #0
 
+FRAME_DONE:
 	// Final clear for the word
 	PREP_GPIO_MASK_NAMED(all)
 	PREP_GPIO_ADDRS_FOR_CLEAR()
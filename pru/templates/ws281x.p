@@ -14,11 +14,18 @@
 //
 // each pixel is stored in 4 bytes in the order GRBA (4th byte is ignored)
 //
+// rows of pixels are r_row_stride bytes apart, and only the first r_num_channels
+// strips of this PRU are read from memory, so using fewer strips reads less DDR.
+//
 // while len > 0:
 //    for bit# = 23 down to 0:
 //        write out bits
 //    increment address by 32
 //
+// The number of bits clocked per pixel and the latch time can be overridden by
+// a template that includes this one (see sk6812.p), so the same code drives
+// 32 bit RGBW strips where the 4th byte is sent first.
+//
 
 //
 //
@@ -32,6 +39,14 @@
 
 #define CHECK_TIMEOUT WAIT_TIMEOUT 3000, FRAME_DONE
 
+#ifndef WS281X_BITS_PER_PIXEL
+#define WS281X_BITS_PER_PIXEL 24
+#endif
+
+#ifndef WS281X_RESET_NS
+#define WS281X_RESET_NS 50000
+#endif
+
 START:
 	// Enable OCP master port
 	// clear the STANDBY_INIT bit in the SYSCFG register,
@@ -91,15 +106,30 @@ _LOOP:
 	// Command of 0xFF is the signal to exit
 	QBEQ EXIT, r2, #0xFF
 
+	// Load the number of bytes per pixel row and the number of channels
+	// this PRU drives, which depend on how many strips are in use
+	LBCO r_row_info, CONST_PRUDRAM, 16, 4
+
+	// Nothing to clock out if all the strips in use belong to the other PRU
+	QBEQ FRAME_DONE, r_num_channels, 0
+
 l_word_loop:
-	// for bit in 24 to 0
-	MOV r_bit_num, 24
+	// for bit in 24 (or 32) to 0
+	MOV r_bit_num, WS281X_BITS_PER_PIXEL
 
 	l_bit_loop:
 		DECREMENT r_bit_num
 
-		// Load 16 registers of data, starting at r10
+		// Load 8 or 16 registers of data, starting at r10.
+		// Registers of channels that are not in use are zeroed, so
+		// those pins send black and we only read the bytes we need
+		QBLT l_load_16_channels, r_num_channels, 8
+		LOAD_CHANNEL_DATA(24, 0, 8)
+		ZERO &r_data8, 32
+		QBA l_first_channels_loaded
+	l_load_16_channels:
 		LOAD_CHANNEL_DATA(24, 0, 16)
+	l_first_channels_loaded:
 
 		// Zero out the registers
 		RESET_GPIO_ZEROS()
@@ -123,8 +153,13 @@ l_word_loop:
 		TEST_BIT_ZERO(r_data14, 14)
 		TEST_BIT_ZERO(r_data15, 15)
 
-		// Load 8 more registers of data
+		// Load 8 more registers of data, if this PRU drives that many channels
+		QBGE l_zero_last_channels, r_num_channels, 16
 		LOAD_CHANNEL_DATA(24, 16, 8)
+		QBA l_last_channels_loaded
+	l_zero_last_channels:
+		ZERO &r_data0, 32
+	l_last_channels_loaded:
 		// Data loaded
 
 		// Load the address(es) of the GPIO devices
@@ -171,7 +206,7 @@ l_word_loop:
 
 	// The RGB streams have been clocked out
 	// Move to the next pixel on each row
-	ADD r_data_addr, r_data_addr, 48 * 4
+	ADD r_data_addr, r_data_addr, r_row_stride
 	DECREMENT r_data_len
 	QBNE l_word_loop, r_data_len, #0
 
@@ -183,9 +218,9 @@ FRAME_DONE:
 	WAITNS 1200, end_of_frame_clear_wait
 	GPIO_APPLY_MASK_TO_ADDR()
 
-	// Delay at least 50 usec; this is the required reset
+	// Delay at least 50 usec (80 usec for sk6812); this is the required reset
 	// time for the LED strip to update with the new pixels.
-	SLEEPNS 50000, 1, reset_time
+	SLEEPNS WS281X_RESET_NS, 1, reset_time
 
 	// Write out that we are done!
 	// Store a non-zero response in the buffer so that they know that we are done
@@ -0,0 +1,222 @@
+/** \file
+ * eBPF socket filters, assembled at run time.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include "sockbpf.h"
+#include "util.h"
+
+#ifndef SO_ATTACH_BPF
+#define SO_ATTACH_BPF 50
+#endif
+
+
+static int
+sockbpf_syscall(
+	int cmd,
+	union bpf_attr * const attr
+)
+{
+	return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+
+bool
+sockbpf_init(
+	sockbpf_prog_t * const prog,
+	unsigned num_counters
+)
+{
+	return sockbpf_init_map(prog, BPF_MAP_TYPE_ARRAY, sizeof(uint64_t), num_counters);
+}
+
+
+bool
+sockbpf_init_map(
+	sockbpf_prog_t * const prog,
+	uint32_t map_type,
+	uint32_t value_size,
+	uint32_t max_entries
+)
+{
+	memset(prog, 0, sizeof(*prog));
+	memset(prog->labels, -1, sizeof(prog->labels));
+
+	union bpf_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.map_type = map_type;
+	attr.key_size = sizeof(uint32_t);
+	attr.value_size = value_size;
+	attr.max_entries = max_entries;
+	prog->map_fd = sockbpf_syscall(BPF_MAP_CREATE, &attr);
+	if (prog->map_fd < 0) {
+		warn("sockbpf: map create failed: %s\n", strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+
+void
+sockbpf_emit(
+	sockbpf_prog_t * const prog,
+	struct bpf_insn insn
+)
+{
+	if (prog->count >= SOCKBPF_MAX_INSNS)
+		die("sockbpf: more than %d instructions\n", SOCKBPF_MAX_INSNS);
+	prog->insns[prog->count++] = insn;
+}
+
+
+void
+sockbpf_jump_imm(
+	sockbpf_prog_t * const prog,
+	uint8_t op,
+	uint8_t dst,
+	int32_t imm,
+	unsigned label
+)
+{
+	prog->jump_label[prog->count] = label + 1;
+	sockbpf_emit(prog, SOCKBPF_INSN(BPF_JMP | op | BPF_K, dst, 0, 0, imm));
+}
+
+
+void
+sockbpf_jump_reg(
+	sockbpf_prog_t * const prog,
+	uint8_t op,
+	uint8_t dst,
+	uint8_t src,
+	unsigned label
+)
+{
+	prog->jump_label[prog->count] = label + 1;
+	sockbpf_emit(prog, SOCKBPF_INSN(BPF_JMP | op | BPF_X, dst, src, 0, 0));
+}
+
+
+void
+sockbpf_label(
+	sockbpf_prog_t * const prog,
+	unsigned label
+)
+{
+	if (label >= SOCKBPF_MAX_LABELS)
+		die("sockbpf: label %u out of range\n", label);
+	prog->labels[label] = prog->count;
+}
+
+
+void
+sockbpf_load_map(
+	sockbpf_prog_t * const prog,
+	uint8_t dst
+)
+{
+	// a 64 bit immediate takes two instructions
+	sockbpf_emit(prog, SOCKBPF_INSN(BPF_LD | BPF_DW | BPF_IMM, dst, BPF_PSEUDO_MAP_FD, 0, prog->map_fd));
+	sockbpf_emit(prog, SOCKBPF_INSN(0, 0, 0, 0, 0));
+}
+
+
+int
+sockbpf_load(
+	sockbpf_prog_t * const prog,
+	uint32_t prog_type,
+	uint32_t expected_attach_type
+)
+{
+	for (unsigned i = 0 ; i < prog->count ; i++)
+	{
+		if (prog->jump_label[i] == 0)
+			continue;
+		const int target = prog->labels[prog->jump_label[i] - 1];
+		if (target < 0)
+			die("sockbpf: jump to label %u, which was never placed\n", prog->jump_label[i] - 1);
+		prog->insns[i].off = target - (int)(i + 1);
+	}
+
+	static char log[16384];
+	union bpf_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.prog_type = prog_type;
+	attr.expected_attach_type = expected_attach_type;
+	attr.insns = (uintptr_t) prog->insns;
+	attr.insn_cnt = prog->count;
+	attr.license = (uintptr_t) "GPL";
+	attr.log_buf = (uintptr_t) log;
+	attr.log_size = sizeof(log);
+	attr.log_level = 1;
+	log[0] = '\0';
+
+	const int prog_fd = sockbpf_syscall(BPF_PROG_LOAD, &attr);
+	if (prog_fd < 0)
+		warn("sockbpf: program load failed: %s\n%s", strerror(errno), log);
+	return prog_fd;
+}
+
+
+bool
+sockbpf_attach(
+	sockbpf_prog_t * const prog,
+	int sock
+)
+{
+	const int prog_fd = sockbpf_load(prog, BPF_PROG_TYPE_SOCKET_FILTER, 0);
+	if (prog_fd < 0)
+		return false;
+	if (setsockopt(sock, SOL_SOCKET, SO_ATTACH_BPF, &prog_fd, sizeof(prog_fd)) < 0) {
+		warn("sockbpf: attach failed: %s\n", strerror(errno));
+		close(prog_fd);
+		return false;
+	}
+
+	// the socket holds the program now
+	close(prog_fd);
+	return true;
+}
+
+
+bool
+sockbpf_map_set(
+	const sockbpf_prog_t * const prog,
+	uint32_t key,
+	const void * value
+)
+{
+	union bpf_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.map_fd = prog->map_fd;
+	attr.key = (uintptr_t) &key;
+	attr.value = (uintptr_t) value;
+	attr.flags = BPF_ANY;
+	if (sockbpf_syscall(BPF_MAP_UPDATE_ELEM, &attr) < 0) {
+		warn("sockbpf: map update failed: %s\n", strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+
+uint64_t
+sockbpf_counter(
+	const sockbpf_prog_t * const prog,
+	uint32_t counter
+)
+{
+	uint64_t value = 0;
+	union bpf_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.map_fd = prog->map_fd;
+	attr.key = (uintptr_t) &counter;
+	attr.value = (uintptr_t) &value;
+	if (sockbpf_syscall(BPF_MAP_LOOKUP_ELEM, &attr) < 0)
+		return 0;
+	return value;
+}
@@ -0,0 +1,160 @@
+/** \file
+ * eBPF socket filters, assembled at run time.
+ *
+ * A socket filter runs in the kernel on every datagram before it is
+ * queued on the socket, so datagrams it drops are never copied to user
+ * space. The program is built with the instruction macros below, which
+ * follow the kernel's own (they are not part of its user space headers),
+ * and jumps go to labels that are resolved when the program is loaded.
+ * Drop counters are kept in an array map of 64 bit counters, which the
+ * program increments and user space reads.
+ *
+ * For UDP sockets the filter sees the UDP header first, so the datagram
+ * starts at offset SOCKBPF_UDP_PAYLOAD.
+ *
+ * The same assembler builds other program types, like the XDP program of
+ * xsk.h, with another kind of map, loaded with sockbpf_load().
+ */
+#ifndef _sockbpf_h_
+#define _sockbpf_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <linux/bpf.h>
+
+#define SOCKBPF_UDP_PAYLOAD 8
+#define SOCKBPF_MAX_INSNS 512
+#define SOCKBPF_MAX_LABELS 32
+
+#define SOCKBPF_INSN(c, d, s, o, i) \
+	((struct bpf_insn) { .code = (c), .dst_reg = (d), .src_reg = (s), .off = (o), .imm = (i) })
+
+#define SOCKBPF_MOV64_REG(d, s)		SOCKBPF_INSN(BPF_ALU64 | BPF_MOV | BPF_X, d, s, 0, 0)
+#define SOCKBPF_MOV64_IMM(d, i)		SOCKBPF_INSN(BPF_ALU64 | BPF_MOV | BPF_K, d, 0, 0, i)
+#define SOCKBPF_MOV32_IMM(d, i)		SOCKBPF_INSN(BPF_ALU | BPF_MOV | BPF_K, d, 0, 0, i)
+#define SOCKBPF_ALU64_REG(op, d, s)	SOCKBPF_INSN(BPF_ALU64 | (op) | BPF_X, d, s, 0, 0)
+#define SOCKBPF_ALU64_IMM(op, d, i)	SOCKBPF_INSN(BPF_ALU64 | (op) | BPF_K, d, 0, 0, i)
+#define SOCKBPF_LD_ABS(size, off)	SOCKBPF_INSN(BPF_LD | (size) | BPF_ABS, 0, 0, 0, off) // into r0, big endian
+#define SOCKBPF_LDX_MEM(size, d, s, o)	SOCKBPF_INSN(BPF_LDX | (size) | BPF_MEM, d, s, o, 0)
+#define SOCKBPF_STX_MEM(size, d, s, o)	SOCKBPF_INSN(BPF_STX | (size) | BPF_MEM, d, s, o, 0)
+#define SOCKBPF_ST_MEM(size, d, o, i)	SOCKBPF_INSN(BPF_ST | (size) | BPF_MEM, d, 0, o, i)
+#define SOCKBPF_ATOMIC_ADD64(d, s, o)	SOCKBPF_INSN(BPF_STX | BPF_DW | BPF_XADD, d, s, o, 0)
+#define SOCKBPF_CALL(f)			SOCKBPF_INSN(BPF_JMP | BPF_CALL, 0, 0, 0, f)
+#define SOCKBPF_EXIT()			SOCKBPF_INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0)
+
+typedef struct {
+	struct bpf_insn insns[SOCKBPF_MAX_INSNS];
+	uint8_t jump_label[SOCKBPF_MAX_INSNS]; // label + 1 of a jump, 0 for anything else
+	int labels[SOCKBPF_MAX_LABELS]; // instruction of a label, -1 until placed
+	unsigned count;
+	int map_fd;
+} sockbpf_prog_t;
+
+
+/** Start a program, with an array map of num_counters counters.
+ *
+ * \returns false if the kernel doesn't allow maps, which are the first
+ * thing a filter needs.
+ */
+extern bool
+sockbpf_init(
+	sockbpf_prog_t * const prog,
+	unsigned num_counters
+);
+
+/** Start a program, with a map of another type, keyed by 32 bit indexes.
+ *
+ * \returns false if the kernel refused the map.
+ */
+extern bool
+sockbpf_init_map(
+	sockbpf_prog_t * const prog,
+	uint32_t map_type,
+	uint32_t value_size,
+	uint32_t max_entries
+);
+
+extern void
+sockbpf_emit(
+	sockbpf_prog_t * const prog,
+	struct bpf_insn insn
+);
+
+/** Jump to label if (dst op imm), op being BPF_JEQ, BPF_JGT and the like.
+ * BPF_JA jumps always.
+ */
+extern void
+sockbpf_jump_imm(
+	sockbpf_prog_t * const prog,
+	uint8_t op,
+	uint8_t dst,
+	int32_t imm,
+	unsigned label
+);
+
+/** Jump to label if (dst op src) */
+extern void
+sockbpf_jump_reg(
+	sockbpf_prog_t * const prog,
+	uint8_t op,
+	uint8_t dst,
+	uint8_t src,
+	unsigned label
+);
+
+/** The next instruction is the label */
+extern void
+sockbpf_label(
+	sockbpf_prog_t * const prog,
+	unsigned label
+);
+
+/** r0 = the 64 bit map fd, for helpers taking the map */
+extern void
+sockbpf_load_map(
+	sockbpf_prog_t * const prog,
+	uint8_t dst
+);
+
+/** Resolve the labels and load the program, of a BPF_PROG_TYPE_*.
+ *
+ * \returns the program's fd, or -1 if the kernel refused it, with the
+ * verifier's log printed.
+ */
+extern int
+sockbpf_load(
+	sockbpf_prog_t * const prog,
+	uint32_t prog_type,
+	uint32_t expected_attach_type
+);
+
+/** Resolve the labels, load the program and attach it to the socket.
+ *
+ * \returns false if the kernel refused it, with the verifier's log
+ * printed.
+ */
+extern bool
+sockbpf_attach(
+	sockbpf_prog_t * const prog,
+	int sock
+);
+
+/** Set an entry of the map.
+ *
+ * \returns false if the kernel refused the value.
+ */
+extern bool
+sockbpf_map_set(
+	const sockbpf_prog_t * const prog,
+	uint32_t key,
+	const void * value
+);
+
+/** The current value of a counter of the map */
+extern uint64_t
+sockbpf_counter(
+	const sockbpf_prog_t * const prog,
+	uint32_t counter
+);
+
+#endif
@@ -0,0 +1,130 @@
+/** \file
+ * DMX universes mapped onto strips, for the Art-Net and E1.31 receivers.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "universe.h"
+#include "util.h"
+
+#define UNIVERSE_MAX 63999 // E1.31 universes are 1 - 63999, Art-Net's 0 - 32767
+
+
+static universe_map_t *
+universe_map_alloc(
+	uint16_t first_universe,
+	unsigned num_universes
+)
+{
+	universe_map_t * const map = calloc(1, sizeof(*map));
+	if (!map)
+		die("universe: unable to allocate\n");
+	map->first_universe = first_universe;
+	map->num_universes = num_universes;
+	map->ranges = calloc(num_universes, sizeof(*map->ranges));
+	if (!map->ranges)
+		die("universe: unable to allocate %u universes\n", num_universes);
+	return map;
+}
+
+
+universe_map_t *
+universe_map_init(
+	uint16_t first_universe,
+	unsigned num_strips,
+	unsigned num_pixels,
+	unsigned pixels_per_universe
+)
+{
+	const unsigned universes_per_strip = (num_pixels + pixels_per_universe - 1) / pixels_per_universe;
+	universe_map_t * const map = universe_map_alloc(first_universe, num_strips * universes_per_strip);
+	map->num_mapped = map->num_universes;
+
+	for (unsigned u = 0 ; u < map->num_universes ; u++)
+	{
+		universe_range_t * const range = &map->ranges[u];
+		range->strip = u / universes_per_strip;
+		range->pixel = (u % universes_per_strip) * pixels_per_universe;
+		range->num_pixels = num_pixels - range->pixel < pixels_per_universe ?
+			num_pixels - range->pixel : pixels_per_universe;
+		range->segment = u;
+	}
+
+	return map;
+}
+
+
+universe_map_t *
+universe_map_load(
+	const char * const filename,
+	unsigned num_strips,
+	unsigned num_pixels
+)
+{
+	FILE * const file = fopen(filename, "r");
+	if (!file)
+		die("universe: unable to open %s: %s\n", filename, strerror(errno));
+
+	// two passes: the first finds the span of the table
+	unsigned lowest = UNIVERSE_MAX, highest = 0;
+	universe_map_t * map = NULL;
+	for (int pass = 0 ; pass < 2 ; pass++)
+	{
+		rewind(file);
+		char line[256];
+		unsigned line_num = 0;
+		while (fgets(line, sizeof(line), file))
+		{
+			line_num++;
+			char * const comment = strchr(line, '#');
+			if (comment)
+				*comment = '\0';
+
+			unsigned universe, strip, pixel, pixels;
+			char extra;
+			const int count = sscanf(line, "%u %u %u %u %c", &universe, &strip, &pixel, &pixels, &extra);
+			if (count <= 0)
+				continue;
+			if (count != 4)
+				die("universe: %s:%u: expected <universe> <strip> <first pixel> <pixels>\n", filename, line_num);
+			if (universe > UNIVERSE_MAX || strip >= num_strips || pixels == 0
+			|| pixels > UNIVERSE_MAX_PIXELS || pixel + pixels > num_pixels)
+				die("universe: %s:%u: universe %u doesn't fit %u strips x %u pixels\n",
+					filename, line_num, universe, num_strips, num_pixels);
+
+			if (pass == 0) {
+				lowest = universe < lowest ? universe : lowest;
+				highest = universe > highest ? universe : highest;
+				continue;
+			}
+
+			universe_range_t * const range = &map->ranges[universe - map->first_universe];
+			if (range->num_pixels != 0)
+				die("universe: %s:%u: universe %u is mapped twice\n", filename, line_num, universe);
+			range->strip = strip;
+			range->pixel = pixel;
+			range->num_pixels = pixels;
+			range->segment = map->num_mapped++;
+		}
+
+		if (pass == 0) {
+			if (highest < lowest)
+				die("universe: %s maps no universes\n", filename);
+			map = universe_map_alloc(lowest, highest - lowest + 1);
+		}
+	}
+
+	fclose(file);
+	return map;
+}
+
+
+void
+universe_map_close(
+	universe_map_t * const map
+)
+{
+	free(map->ranges);
+	free(map);
+}
@@ -0,0 +1,75 @@
+/** \file
+ * DMX universes mapped onto strips, for the Art-Net and E1.31 receivers.
+ *
+ * By default universes are mapped onto the strips in order: from the
+ * first universe, each strip takes enough universes for its pixels, and
+ * each universe holds pixels_per_universe RGB pixels (170 fill the 512
+ * DMX channels). A map file gives the range of every universe instead,
+ * one entry per line, '#' starts a comment:
+ *
+ *	<universe> <strip> <first pixel> <pixels>
+ *
+ * The map is a table by universe, so a packet costs a lookup before its
+ * pixels are painted like any other RGB payload.
+ */
+#ifndef _universe_h_
+#define _universe_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define UNIVERSE_MAX_PIXELS 170 // RGB pixels in 512 channels
+
+typedef struct {
+	uint16_t strip;
+	uint16_t pixel;
+	uint16_t num_pixels; // 0 if the universe is not mapped
+	uint16_t segment; // of the frame, from 0 to num_mapped - 1
+} universe_range_t;
+
+typedef struct {
+	uint16_t first_universe;
+	unsigned num_universes; // from the first to the last mapped universe
+	unsigned num_mapped;
+	universe_range_t * ranges; // by universe - first_universe
+} universe_map_t;
+
+
+extern universe_map_t *
+universe_map_init(
+	uint16_t first_universe,
+	unsigned num_strips,
+	unsigned num_pixels,
+	unsigned pixels_per_universe
+);
+
+/** Load a map file for frames of num_strips by num_pixels.
+ *
+ * Exits on a malformed file, or on ranges outside of the frame.
+ */
+extern universe_map_t *
+universe_map_load(
+	const char * const filename,
+	unsigned num_strips,
+	unsigned num_pixels
+);
+
+extern void
+universe_map_close(
+	universe_map_t * const map
+);
+
+/** The strip range of a universe, or NULL if it is not ours */
+static inline const universe_range_t *
+universe_map_lookup(
+	const universe_map_t * const map,
+	uint16_t universe
+) {
+	const unsigned index = (uint16_t)(universe - map->first_universe);
+	if (index >= map->num_universes || map->ranges[index].num_pixels == 0)
+		return NULL;
+	return &map->ranges[index];
+}
+
+#endif
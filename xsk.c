@@ -0,0 +1,342 @@
+/** \file
+ * AF_XDP receive sockets.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <linux/if_ether.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include "xsk.h"
+#include "util.h"
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+// the offsets of the headers the program reads, in an untagged IPv4 frame without options
+#define XSK_IP (ETH_HLEN)
+#define XSK_UDP (XSK_IP + 20)
+#define XSK_PAYLOAD (XSK_UDP + 8)
+
+enum { XSK_PASS, XSK_REDIRECT };
+
+
+// pass everything but the datagrams to the port and the addresses, and redirect those to the
+// socket of their queue. a queue without a socket makes bpf_redirect_map pass, with the
+// action in its flags (linux 5.3)
+static void
+xsk_build(
+	sockbpf_prog_t * const prog,
+	uint16_t port,
+	const struct in_addr * addrs,
+	unsigned num_addrs
+)
+{
+	// r6 = ctx, r2 = the frame, r3 = its end. packet loads are in network order
+	sockbpf_emit(prog, SOCKBPF_MOV64_REG(BPF_REG_6, BPF_REG_1));
+	sockbpf_emit(prog, SOCKBPF_LDX_MEM(BPF_W, BPF_REG_2, BPF_REG_6, offsetof(struct xdp_md, data)));
+	sockbpf_emit(prog, SOCKBPF_LDX_MEM(BPF_W, BPF_REG_3, BPF_REG_6, offsetof(struct xdp_md, data_end)));
+	sockbpf_emit(prog, SOCKBPF_MOV64_REG(BPF_REG_4, BPF_REG_2));
+	sockbpf_emit(prog, SOCKBPF_ALU64_IMM(BPF_ADD, BPF_REG_4, XSK_PAYLOAD));
+	sockbpf_jump_reg(prog, BPF_JGT, BPF_REG_4, BPF_REG_3, XSK_PASS);
+	sockbpf_emit(prog, SOCKBPF_MOV64_REG(BPF_REG_4, BPF_REG_2));
+	sockbpf_emit(prog, SOCKBPF_ALU64_IMM(BPF_ADD, BPF_REG_4, XSK_MAX_PACKET));
+	sockbpf_jump_reg(prog, BPF_JLT, BPF_REG_4, BPF_REG_3, XSK_PASS);
+
+	sockbpf_emit(prog, SOCKBPF_LDX_MEM(BPF_H, BPF_REG_5, BPF_REG_2, 12));
+	sockbpf_jump_imm(prog, BPF_JNE, BPF_REG_5, htons(ETH_P_IP), XSK_PASS);
+	sockbpf_emit(prog, SOCKBPF_LDX_MEM(BPF_B, BPF_REG_5, BPF_REG_2, XSK_IP));
+	sockbpf_jump_imm(prog, BPF_JNE, BPF_REG_5, 0x45, XSK_PASS); // version 4, no options
+	sockbpf_emit(prog, SOCKBPF_LDX_MEM(BPF_H, BPF_REG_5, BPF_REG_2, XSK_IP + 6));
+	sockbpf_jump_imm(prog, BPF_JSET, BPF_REG_5, htons(0x3FFF), XSK_PASS); // fragments are reassembled by the stack
+	sockbpf_emit(prog, SOCKBPF_LDX_MEM(BPF_B, BPF_REG_5, BPF_REG_2, XSK_IP + 9));
+	sockbpf_jump_imm(prog, BPF_JNE, BPF_REG_5, IPPROTO_UDP, XSK_PASS);
+	sockbpf_emit(prog, SOCKBPF_LDX_MEM(BPF_H, BPF_REG_5, BPF_REG_2, XSK_UDP + 2));
+	sockbpf_jump_imm(prog, BPF_JNE, BPF_REG_5, htons(port), XSK_PASS);
+
+	if (num_addrs > 0) {
+		// a 32 bit move, as immediates are sign extended to 64 bits
+		sockbpf_emit(prog, SOCKBPF_LDX_MEM(BPF_W, BPF_REG_5, BPF_REG_2, XSK_IP + 16));
+		for (unsigned i = 0 ; i < num_addrs ; i++) {
+			sockbpf_emit(prog, SOCKBPF_MOV32_IMM(BPF_REG_1, addrs[i].s_addr));
+			sockbpf_jump_reg(prog, BPF_JEQ, BPF_REG_5, BPF_REG_1, XSK_REDIRECT);
+		}
+		sockbpf_jump_imm(prog, BPF_JA, 0, 0, XSK_PASS);
+	}
+
+	sockbpf_label(prog, XSK_REDIRECT);
+	sockbpf_load_map(prog, BPF_REG_1);
+	sockbpf_emit(prog, SOCKBPF_LDX_MEM(BPF_W, BPF_REG_2, BPF_REG_6, offsetof(struct xdp_md, rx_queue_index)));
+	sockbpf_emit(prog, SOCKBPF_MOV64_IMM(BPF_REG_3, XDP_PASS));
+	sockbpf_emit(prog, SOCKBPF_CALL(BPF_FUNC_redirect_map));
+	sockbpf_emit(prog, SOCKBPF_EXIT());
+
+	sockbpf_label(prog, XSK_PASS);
+	sockbpf_emit(prog, SOCKBPF_MOV64_IMM(BPF_REG_0, XDP_PASS));
+	sockbpf_emit(prog, SOCKBPF_EXIT());
+}
+
+
+// attach the program for as long as the link is open (linux 5.9)
+static int
+xsk_link(
+	int prog_fd,
+	int ifindex,
+	uint32_t flags
+)
+{
+	union bpf_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.link_create.prog_fd = prog_fd;
+	attr.link_create.target_ifindex = ifindex;
+	attr.link_create.attach_type = BPF_XDP;
+	attr.link_create.flags = flags;
+	return syscall(__NR_bpf, BPF_LINK_CREATE, &attr, sizeof(attr));
+}
+
+
+static bool
+xsk_map_ring(
+	xsk_t * const xsk,
+	xsk_ring_t * const ring,
+	const struct xdp_ring_offset * const off,
+	size_t entry_size,
+	off_t pgoff
+)
+{
+	ring->map_size = off->desc + XSK_NUM_FRAMES * entry_size;
+	ring->map = mmap(NULL, ring->map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, xsk->fd, pgoff);
+	if (ring->map == MAP_FAILED) {
+		ring->map = NULL;
+		return false;
+	}
+	ring->producer = (uint32_t *)((uint8_t *) ring->map + off->producer);
+	ring->consumer = (uint32_t *)((uint8_t *) ring->map + off->consumer);
+	ring->ring = (uint8_t *) ring->map + off->desc;
+	ring->mask = XSK_NUM_FRAMES - 1;
+	return true;
+}
+
+
+// the umem, its fill and receive rings. the completion ring is only for sending, but the kernel wants it
+static bool
+xsk_setup_socket(
+	xsk_t * const xsk
+)
+{
+	xsk->umem = mmap(NULL, XSK_NUM_FRAMES * XSK_FRAME_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (xsk->umem == MAP_FAILED) {
+		xsk->umem = NULL;
+		warn("xsk: umem allocation failed: %s\n", strerror(errno));
+		return false;
+	}
+
+	struct xdp_umem_reg reg;
+	memset(&reg, 0, sizeof(reg));
+	reg.addr = (uintptr_t) xsk->umem;
+	reg.len = XSK_NUM_FRAMES * XSK_FRAME_SIZE;
+	reg.chunk_size = XSK_FRAME_SIZE;
+	const int ring_size = XSK_NUM_FRAMES;
+	const int completion_size = 64;
+	if (setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) < 0
+	||  setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_FILL_RING, &ring_size, sizeof(ring_size)) < 0
+	||  setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &completion_size, sizeof(completion_size)) < 0
+	||  setsockopt(xsk->fd, SOL_XDP, XDP_RX_RING, &ring_size, sizeof(ring_size)) < 0) {
+		warn("xsk: umem and ring setup failed: %s\n", strerror(errno));
+		return false;
+	}
+
+	struct xdp_mmap_offsets off;
+	socklen_t len = sizeof(off);
+	if (getsockopt(xsk->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &len) < 0
+	||  !xsk_map_ring(xsk, &xsk->fill, &off.fr, sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING)
+	||  !xsk_map_ring(xsk, &xsk->rx, &off.rx, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING)) {
+		warn("xsk: ring mapping failed: %s\n", strerror(errno));
+		return false;
+	}
+
+	// every frame starts in the fill ring
+	uint64_t * const fill = xsk->fill.ring;
+	for (unsigned i = 0 ; i < XSK_NUM_FRAMES ; i++)
+		fill[i] = (uint64_t) i * XSK_FRAME_SIZE;
+	__atomic_store_n(xsk->fill.producer, XSK_NUM_FRAMES, __ATOMIC_RELEASE);
+	return true;
+}
+
+
+static bool
+xsk_bind(
+	xsk_t * const xsk,
+	int ifindex,
+	uint16_t flags
+)
+{
+	struct sockaddr_xdp addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sxdp_family = AF_XDP;
+	addr.sxdp_ifindex = ifindex;
+	addr.sxdp_queue_id = xsk->queue;
+	addr.sxdp_flags = flags;
+	return bind(xsk->fd, (const struct sockaddr *) &addr, sizeof(addr)) == 0;
+}
+
+
+xsk_t *
+xsk_open(
+	const char * ifname,
+	unsigned queue,
+	uint16_t port,
+	const struct in_addr * addrs,
+	unsigned num_addrs,
+	xsk_mode_t mode
+)
+{
+	const int ifindex = if_nametoindex(ifname);
+	if (ifindex == 0) {
+		warn("xsk: unknown interface %s\n", ifname);
+		return NULL;
+	}
+	if (num_addrs > XSK_MAX_ADDRS)
+		num_addrs = XSK_MAX_ADDRS;
+
+	xsk_t * const xsk = calloc(1, sizeof(*xsk));
+	if (!xsk)
+		die("xsk: unable to allocate\n");
+	xsk->fd = xsk->link_fd = -1;
+	xsk->queue = queue;
+
+	if (!sockbpf_init_map(&xsk->prog, BPF_MAP_TYPE_XSKMAP, sizeof(int), queue + 1))
+		goto fail;
+	xsk_build(&xsk->prog, port, addrs, num_addrs);
+	const int prog_fd = sockbpf_load(&xsk->prog, BPF_PROG_TYPE_XDP, BPF_XDP);
+	if (prog_fd < 0)
+		goto fail;
+
+	if (mode != XSK_MODE_GENERIC)
+		xsk->link_fd = xsk_link(prog_fd, ifindex, XDP_FLAGS_DRV_MODE);
+	if (xsk->link_fd < 0 && mode != XSK_MODE_NATIVE) {
+		xsk->generic = true;
+		xsk->link_fd = xsk_link(prog_fd, ifindex, XDP_FLAGS_SKB_MODE);
+	}
+	close(prog_fd);
+	if (xsk->link_fd < 0) {
+		warn("xsk: attaching the XDP program to %s failed: %s\n", ifname, strerror(errno));
+		goto fail;
+	}
+
+	xsk->fd = socket(AF_XDP, SOCK_RAW, 0);
+	if (xsk->fd < 0) {
+		warn("xsk: socket failed: %s\n", strerror(errno));
+		goto fail;
+	}
+	if (!xsk_setup_socket(xsk))
+		goto fail;
+
+	// zero copy needs the program in the driver, and the driver's support
+	xsk->zero_copy = !xsk->generic && xsk_bind(xsk, ifindex, XDP_ZEROCOPY);
+	if (!xsk->zero_copy && !xsk_bind(xsk, ifindex, XDP_COPY)) {
+		warn("xsk: bind to %s queue %u failed: %s\n", ifname, queue, strerror(errno));
+		goto fail;
+	}
+	if (!sockbpf_map_set(&xsk->prog, queue, &xsk->fd))
+		goto fail;
+	return xsk;
+
+fail:
+	xsk_close(xsk);
+	return NULL;
+}
+
+
+void
+xsk_poll(
+	xsk_t * const xsk,
+	void (*handle)(const uint8_t buf[], int len, const struct sockaddr_in6 * from)
+)
+{
+	const uint32_t produced = __atomic_load_n(xsk->rx.producer, __ATOMIC_ACQUIRE);
+	uint32_t consumed = *xsk->rx.consumer;
+	if (consumed == produced)
+		return;
+
+	const struct xdp_desc * const descs = xsk->rx.ring;
+	uint64_t * const fill = xsk->fill.ring;
+	uint32_t filled = *xsk->fill.producer;
+	struct sockaddr_in6 from;
+	memset(&from, 0, sizeof(from));
+	from.sin6_family = AF_INET6;
+	from.sin6_addr.s6_addr[10] = from.sin6_addr.s6_addr[11] = 0xFF;
+
+	for ( ; consumed != produced ; consumed++) {
+		const struct xdp_desc * const desc = &descs[consumed & xsk->rx.mask];
+		const uint8_t * const frame = xsk->umem + desc->addr;
+
+		// the program only steers datagrams with these headers. the udp length may be shorter than
+		// the frame, which ethernet pads to its minimum size
+		if (desc->len >= XSK_PAYLOAD) {
+			const unsigned udp_len = (frame[XSK_UDP + 4] << 8) | frame[XSK_UDP + 5];
+			memcpy(&from.sin6_addr.s6_addr[12], &frame[XSK_IP + 12], 4);
+			memcpy(&from.sin6_port, &frame[XSK_UDP], 2);
+			if (udp_len >= 8 && udp_len <= desc->len - XSK_UDP) {
+				xsk->packets++;
+				handle(frame + XSK_PAYLOAD, udp_len - 8, &from);
+			}
+		}
+
+		fill[filled++ & xsk->fill.mask] = desc->addr & ~(uint64_t)(XSK_FRAME_SIZE - 1);
+	}
+
+	__atomic_store_n(xsk->fill.producer, filled, __ATOMIC_RELEASE);
+	__atomic_store_n(xsk->rx.consumer, consumed, __ATOMIC_RELEASE);
+}
+
+
+void
+xsk_print_stats(
+	const xsk_t * const xsk
+)
+{
+	struct xdp_statistics stats;
+	socklen_t len = sizeof(stats);
+	memset(&stats, 0, sizeof(stats));
+	getsockopt(xsk->fd, SOL_XDP, XDP_STATISTICS, &stats, &len);
+	printf("info: xdp: %" PRIu64 " packets, %llu dropped, %llu with the ring full, %llu with no free frame\n",
+		xsk->packets, (unsigned long long) stats.rx_dropped, (unsigned long long) stats.rx_ring_full,
+		(unsigned long long) stats.rx_fill_ring_empty_descs);
+}
+
+
+void
+xsk_close(
+	xsk_t * const xsk
+)
+{
+	if (!xsk)
+		return;
+	// the program goes first, so nothing is redirected to a socket being torn down
+	if (xsk->link_fd >= 0)
+		close(xsk->link_fd);
+	if (xsk->fd >= 0)
+		close(xsk->fd);
+	if (xsk->prog.map_fd > 0)
+		close(xsk->prog.map_fd);
+	if (xsk->rx.map)
+		munmap(xsk->rx.map, xsk->rx.map_size);
+	if (xsk->fill.map)
+		munmap(xsk->fill.map, xsk->fill.map_size);
+	if (xsk->umem)
+		munmap(xsk->umem, XSK_NUM_FRAMES * XSK_FRAME_SIZE);
+	free(xsk);
+}
@@ -0,0 +1,99 @@
+/** \file
+ * AF_XDP receive sockets.
+ *
+ * A small XDP program on the interface steers the UDP datagrams for a
+ * port, sent to one of a few IPv4 addresses, into the UMEM of an AF_XDP
+ * socket, before the kernel allocates anything for them, and the server
+ * takes them from its receive ring without a system call. Everything else
+ * passes to the stack as usual: other traffic, IPv6, IP fragments, and
+ * datagrams too long for a UMEM frame. The program is assembled with
+ * sockbpf.h.
+ *
+ * Zero copy needs the driver's support; otherwise the kernel copies the
+ * packets into the UMEM. Drivers without XDP support at all get the
+ * generic (skb) mode, which is also how it is tried out on veth.
+ *
+ * A socket receives a single queue of the interface. Packets of the other
+ * queues miss the socket map, and pass to the stack.
+ */
+#ifndef _xsk_h_
+#define _xsk_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <netinet/in.h>
+#include "sockbpf.h"
+
+#define XSK_FRAME_SIZE 2048
+#define XSK_NUM_FRAMES 2048
+#define XSK_MAX_ADDRS 8
+#define XSK_MAX_PACKET (XSK_FRAME_SIZE - 256) // the headroom of XDP_PACKET_HEADROOM
+
+typedef enum {
+	XSK_MODE_AUTO, // native, or generic if the driver has no XDP support
+	XSK_MODE_NATIVE,
+	XSK_MODE_GENERIC,
+} xsk_mode_t;
+
+typedef struct {
+	uint32_t * producer;
+	uint32_t * consumer;
+	void * ring; // descriptors, or frame addresses of the fill ring
+	uint32_t mask;
+	void * map;
+	size_t map_size;
+} xsk_ring_t;
+
+typedef struct {
+	int fd;
+	int link_fd; // the XDP program stays on the interface while it is open
+	unsigned queue;
+	bool zero_copy;
+	bool generic;
+	uint8_t * umem;
+	xsk_ring_t rx;
+	xsk_ring_t fill;
+	sockbpf_prog_t prog;
+	uint64_t packets;
+} xsk_t;
+
+
+/** Attach the program to the interface and bind a socket to the queue.
+ *
+ * Datagrams to the port are steered to the socket if they are sent to one
+ * of the addrs, or to any address if there are none.
+ *
+ * \returns NULL if the kernel or the driver refused any of it, with the
+ * reason printed.
+ */
+extern xsk_t *
+xsk_open(
+	const char * ifname,
+	unsigned queue,
+	uint16_t port,
+	const struct in_addr * addrs,
+	unsigned num_addrs,
+	xsk_mode_t mode
+);
+
+/** Hand the datagrams in the receive ring to handle, and give their
+ * frames back to the kernel. from is the sender, as an IPv4 mapped
+ * address.
+ */
+extern void
+xsk_poll(
+	xsk_t * const xsk,
+	void (*handle)(const uint8_t buf[], int len, const struct sockaddr_in6 * from)
+);
+
+extern void
+xsk_print_stats(
+	const xsk_t * const xsk
+);
+
+extern void
+xsk_close(
+	xsk_t * const xsk
+);
+
+#endif